@@ -0,0 +1,1413 @@
+#include "Benchmark.h"
+#include "Chunk.h"
+#include "VoxelScene.h"
+#include "NoiseColumnCache.h"
+#include "TerrainGraph.h"
+#include "MPSCQueue.h"
+#include "EpochReclaimer.h"
+#include "Octree.h"
+#include "VoxelCollision.h"
+#include "Window.h"
+#include "GX.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <deque>
+#include <random>
+#include <thread>
+
+// volume that gets generated for each run, in LOD0 chunks
+const int BENCH_CHUNKS_XZ = 16;
+const int BENCH_CHUNKS_Y = 8;
+
+int Benchmark::Run(const char* name)
+{
+	if (strcmp(name, "meshsize") == 0)
+		return MeshSize();
+	if (strcmp(name, "meshstress") == 0)
+		return MeshStress();
+	if (strcmp(name, "meshao") == 0)
+		return MeshAO();
+	if (strcmp(name, "remesh") == 0)
+		return Remesh();
+	if (strcmp(name, "regionedit") == 0)
+		return RegionEdit();
+	if (strcmp(name, "skirts") == 0)
+		return Skirts();
+	if (strcmp(name, "classify") == 0)
+		return Classify();
+	if (strcmp(name, "adaptive") == 0)
+		return Adaptive();
+	if (strcmp(name, "columnnoise") == 0)
+		return ColumnNoise();
+	if (strcmp(name, "terrain") == 0)
+		return Terrain();
+	if (strcmp(name, "lodimages") == 0)
+		return LODImages();
+	if (strcmp(name, "slabs") == 0)
+		return Slabs();
+	if (strcmp(name, "fused") == 0)
+		return Fused();
+	if (strcmp(name, "meshmemory") == 0)
+		return MeshMemory();
+	if (strcmp(name, "queues") == 0)
+		return Queues();
+	if (strcmp(name, "chunkpool") == 0)
+		return ChunkChurn();
+	if (strcmp(name, "chunksize") == 0)
+		return ChunkSize();
+	if (strcmp(name, "collision") == 0)
+		return Collision();
+
+	std::cout << "unknown benchmark " << name << ". options are: meshsize, meshstress, meshao, remesh, regionedit, skirts, classify, adaptive, columnnoise, terrain, lodimages, slabs, fused, meshmemory, queues, chunkpool, chunksize, collision" << std::endl;
+	return -1;
+}
+
+// chunk statics for generating on this thread, and on threadPools threads too if theres one to run generation sub-jobs on
+static void InitChunks(const Chunk::ChunkGenParams& params, ThreadPool* threadPool = nullptr)
+{
+	std::unordered_map<std::thread::id, int> threadIDs;
+	Chunk::ParallelForFunction parallelFor = nullptr;
+	if (threadPool)
+	{
+		threadIDs = threadPool->GetThreadIDs();
+		parallelFor = [threadPool](uint count, const std::function<void(uint)>& func) { threadPool->ParallelFor(count, func); };
+	}
+	threadIDs[std::this_thread::get_id()] = int(threadIDs.size());
+	Chunk::InitShared(threadIDs, [](Chunk*) {}, [](Chunk*) {}, &params, nullptr, parallelFor);
+}
+
+struct GenerationComparison
+{
+	double timeMs[2] = { 0, 0 };
+	size_t allocatedBytes[2] = { 0, 0 };
+	size_t usedBytes = 0;
+	uint numChunks = 0;
+	uint emptyChunks = 0;
+	uint mismatches = 0;
+};
+
+// generates every lod chunk with chunk coords in min to max, exclusive, once after setFlag(false) and once after setFlag(true).
+// y is innermost so columns come one after another. a chunk mismatches if its volume or its quads come out any different
+static GenerationComparison CompareGeneration(const Chunk::ChunkNoiseGenerators& generators, uint lod, const glm::i32vec3& min, const glm::i32vec3& max,
+	const std::function<void(bool)>& setFlag)
+{
+	GenerationComparison comparison;
+	const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+	for (int x = min.x; x < max.x; x++)
+	{
+		for (int z = min.z; z < max.z; z++)
+		{
+			for (int y = min.y; y < max.y; y++)
+			{
+				const glm::vec3 chunkPos = glm::vec3(x, y, z) * chunkSize;
+				Chunk chunks[2] = { Chunk(chunkPos, lod), Chunk(chunkPos, lod) };
+				for (int flag = 0; flag < 2; flag++)
+				{
+					setFlag(flag);
+					auto startTime = std::chrono::high_resolution_clock::now();
+					chunks[flag].GenerateVolume(&generators);
+					std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+					comparison.timeMs[flag] += time.count();
+					comparison.allocatedBytes[flag] += chunks[flag].GetQuads().capacity() * sizeof(Chunk::PackedQuad);
+				}
+
+				const std::vector<Chunk::PackedQuad>& quads0 = chunks[0].GetQuads();
+				const std::vector<Chunk::PackedQuad>& quads1 = chunks[1].GetQuads();
+				bool same = chunks[0].IsEmpty() == chunks[1].IsEmpty() && quads0.size() == quads1.size() &&
+					std::equal(quads0.begin(), quads0.end(), quads1.begin(), [](const Chunk::PackedQuad& a, const Chunk::PackedQuad& b)
+					{
+						return a.position == b.position && a.attributes == b.attributes;
+					});
+				for (uint i = 0; same && !chunks[0].IsEmpty() && i < CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE; i++)
+				{
+					const uint vx = i / (CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE);
+					const uint vy = (i / CHUNK_VOXEL_SIZE) % CHUNK_VOXEL_SIZE;
+					const uint vz = i % CHUNK_VOXEL_SIZE;
+					same = chunks[0].GetBlockType(vx, vy, vz) == chunks[1].GetBlockType(vx, vy, vz);
+				}
+				comparison.usedBytes += quads0.size() * sizeof(Chunk::PackedQuad);
+				comparison.mismatches += !same;
+				comparison.emptyChunks += chunks[0].IsEmpty();
+				comparison.numChunks++;
+			}
+		}
+	}
+	return comparison;
+}
+
+int Benchmark::MeshSize()
+{
+	// everything runs on this thread, chunks are meshed inline at the end of GenerateVolume
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	uint numChunks = 0;
+	uint numMeshedChunks = 0;
+	size_t numQuads = 0;
+	double totalMs = 0;
+	for (int x = -BENCH_CHUNKS_XZ / 2; x < BENCH_CHUNKS_XZ / 2; x++)
+	{
+		for (int y = -BENCH_CHUNKS_Y / 2; y < BENCH_CHUNKS_Y / 2; y++)
+		{
+			for (int z = -BENCH_CHUNKS_XZ / 2; z < BENCH_CHUNKS_XZ / 2; z++)
+			{
+				Chunk chunk(glm::vec3(x, y, z) * float(CHUNK_UNIT_SIZE), 0);
+				auto startTime = std::chrono::high_resolution_clock::now();
+				chunk.GenerateVolume(&generators);
+				std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+				totalMs += time.count();
+
+				numChunks++;
+				if (chunk.GetQuadCount())
+					numMeshedChunks++;
+				numQuads += chunk.GetQuadCount();
+			}
+		}
+	}
+
+	// old format was a uint per vertex, 4 vertices per face, plus 6 indices per face out of a 100k face shared index buffer
+	const size_t oldVertexBytes = numQuads * 4 * sizeof(uint);
+	const size_t oldIndexBytes = numQuads * 6 * sizeof(uint);
+	const size_t oldSharedIndexBytes = 100000 * 6 * sizeof(uint);
+	const size_t newBytes = numQuads * sizeof(Chunk::PackedQuad);
+
+	std::cout << "chunks: " << numChunks << " (" << numMeshedChunks << " with geometry)" << std::endl;
+	std::cout << "quads: " << numQuads << ", " << double(numQuads) / std::max(numMeshedChunks, 1u) << " per meshed chunk" << std::endl;
+	std::cout << "generate + mesh: " << totalMs << "ms, " << totalMs / numChunks << "ms per chunk" << std::endl;
+	std::cout << "old vertex buffers: " << oldVertexBytes << " bytes (" << oldVertexBytes / std::max(numQuads, size_t(1)) << " per quad)" << std::endl;
+	std::cout << "old index fetch: " << oldIndexBytes << " bytes, shared index buffer " << oldSharedIndexBytes << " bytes" << std::endl;
+	std::cout << "packed quads: " << newBytes << " bytes (" << sizeof(Chunk::PackedQuad) << " per quad)" << std::endl;
+	std::cout << "vertex data reduction: " << double(oldVertexBytes) / std::max(newBytes, size_t(1)) << "x, "
+		<< double(oldVertexBytes + oldIndexBytes) / std::max(newBytes, size_t(1)) << "x counting index fetch" << std::endl;
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::MeshStress()
+{
+	using BlockType = Chunk::BlockType;
+	Chunk::ChunkGenParams params;
+	InitChunks(params);
+
+	// cheap deterministic hash so the random volume is the same every run
+	auto hash = [](int x, int y, int z)
+	{
+		uint h = uint(x) * 73856093u ^ uint(y) * 19349663u ^ uint(z) * 83492791u;
+		h ^= h >> 13;
+		h *= 0x5bd1e995u;
+		return h ^ (h >> 15);
+	};
+
+	struct StressVolume
+	{
+		const char* name;
+		std::function<BlockType(int, int, int)> fn;
+	};
+	const StressVolume volumes[] = {
+		{ "checkerboard", [](int x, int y, int z) { return ((x + y + z) & 1) ? BlockType::Stone : BlockType::Air; } },
+		{ "checkerboard mixed", [](int x, int y, int z) { return ((x + y + z) & 1) ? BlockType(1 + (x & 3)) : BlockType::Air; } },
+		{ "pillars", [](int x, int, int z) { return ((x ^ z) & 1) ? BlockType::Stone : BlockType::Air; } },
+		{ "slabs", [](int, int y, int) { return (y & 1) ? BlockType::Stone : BlockType::Air; } },
+		{ "random 50%", [&hash](int x, int y, int z) { uint h = hash(x, y, z); return (h & 1) ? BlockType(1 + (h >> 1) % 4) : BlockType::Air; } },
+		{ "random 10%", [&hash](int x, int y, int z) { return (hash(x, y, z) % 10 == 0) ? BlockType::Stone : BlockType::Air; } },
+		{ "solid", [](int, int, int) { return BlockType::Stone; } },
+	};
+
+	const int iterations = 50;
+	std::cout << "max quads per chunk: " << Chunk::MAX_QUADS << " (" << Chunk::MAX_QUADS * sizeof(Chunk::PackedQuad) << " bytes)" << std::endl;
+	for (const StressVolume& volume : volumes)
+	{
+		Chunk chunk(glm::vec3(0), 0);
+		chunk.GenerateVolumeFromFunction(volume.fn);
+
+		double totalMs = 0;
+		for (int i = 0; i < iterations; i++)
+		{
+			auto startTime = std::chrono::high_resolution_clock::now();
+			chunk.GenerateMesh();
+			std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+			totalMs += time.count();
+		}
+
+		const uint quads = chunk.GetQuadCount();
+		const double msPerMesh = totalMs / iterations;
+		std::cout << volume.name << ": " << quads << " quads, "
+			<< quads * sizeof(Chunk::PackedQuad) << " bytes, "
+			<< msPerMesh << "ms per mesh, "
+			<< quads / msPerMesh / 1000.0 << "M quads/s, "
+			<< 1000.0 / msPerMesh << " chunks/s" << std::endl;
+	}
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::MeshAO()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	// volumes are generated once, each chunk is then remeshed with ao off and on
+	size_t numQuads[2] = { 0, 0 };
+	double meshMs[2] = { 0, 0 };
+	uint numChunks = 0;
+	for (int x = -BENCH_CHUNKS_XZ / 2; x < BENCH_CHUNKS_XZ / 2; x++)
+	{
+		for (int y = -BENCH_CHUNKS_Y / 2; y < BENCH_CHUNKS_Y / 2; y++)
+		{
+			for (int z = -BENCH_CHUNKS_XZ / 2; z < BENCH_CHUNKS_XZ / 2; z++)
+			{
+				Chunk chunk(glm::vec3(x, y, z) * float(CHUNK_UNIT_SIZE), 0);
+				chunk.GenerateVolume(&generators);
+				if (chunk.IsEmpty())
+					continue;
+
+				numChunks++;
+				for (int ao = 0; ao < 2; ao++)
+				{
+					params.ambientOcclusion = bool(ao);
+					auto startTime = std::chrono::high_resolution_clock::now();
+					chunk.GenerateMesh();
+					std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+					meshMs[ao] += time.count();
+					numQuads[ao] += chunk.GetQuadCount();
+				}
+			}
+		}
+	}
+
+	std::cout << "non empty chunks: " << numChunks << std::endl;
+	for (int ao = 0; ao < 2; ao++)
+	{
+		std::cout << "ao " << (ao ? "on: " : "off: ") << numQuads[ao] << " quads, "
+			<< numQuads[ao] * sizeof(Chunk::PackedQuad) << " bytes, "
+			<< meshMs[ao] / std::max(numChunks, 1u) << "ms per mesh" << std::endl;
+	}
+	std::cout << "ao quad count: " << double(numQuads[1]) / std::max(numQuads[0], size_t(1)) << "x" << std::endl;
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::Remesh()
+{
+	using BlockType = Chunk::BlockType;
+	Chunk::ChunkGenParams params;
+	InitChunks(params);
+
+	// rolling hills with some holes in them, so there are plenty of faces and ao to get right
+	auto terrain = [](int x, int y, int z)
+	{
+		const float height = 14.0f + 8.0f * sinf(x * 0.2f) * cosf(z * 0.15f);
+		const bool hole = ((x * 7 + y * 13 + z * 5) % 11) == 0;
+		return (y < height && !hole) ? BlockType(1 + (x + z) % 3) : BlockType::Air;
+	};
+	Chunk chunk(glm::vec3(0), 0);
+	chunk.GenerateVolumeFromFunction(terrain);
+	chunk.GenerateMesh();
+	// first edit does the full mesh and keeps it around
+	chunk.RemeshEdits(Chunk::DirtyPlanes());
+
+	const int numEdits = 1000;
+	double incrementalMs = 0;
+	double fullMs = 0;
+	uint seed = 1;
+	for (int i = 0; i < numEdits; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		glm::i32vec3 index((seed >> 8) % CHUNK_VOXEL_SIZE, (seed >> 16) % CHUNK_VOXEL_SIZE, (seed >> 24) % CHUNK_VOXEL_SIZE);
+		chunk.ReplaceBlockAtIndex(glm::i8vec3(index), (seed & 1) ? BlockType::Air : BlockType::Stone);
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		Chunk::DirtyPlanes dirtyPlanes;
+		dirtyPlanes.AddVoxels(index, index);
+		chunk.RemeshEdits(dirtyPlanes);
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+		incrementalMs += time.count();
+	}
+	// every edit has to come out exactly like meshing the edited volume from scratch
+	const std::vector<Chunk::PackedQuad> editedQuads = *chunk.GetEditedQuads();
+	for (int i = 0; i < 20; i++)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		chunk.GenerateMesh();
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+		fullMs += time.count();
+	}
+
+	const std::vector<Chunk::PackedQuad>& fullQuads = chunk.GetQuads();
+	const bool same = editedQuads.size() == fullQuads.size() &&
+		std::equal(editedQuads.begin(), editedQuads.end(), fullQuads.begin(), [](const Chunk::PackedQuad& a, const Chunk::PackedQuad& b)
+		{
+			return a.position == b.position && a.attributes == b.attributes;
+		});
+
+	std::cout << "quads after edits: " << editedQuads.size() << " (full remesh: " << fullQuads.size() << "), " << (same ? "identical" : "MISMATCH") << std::endl;
+	std::cout << "incremental remesh: " << incrementalMs * 1000.0 / numEdits << "us per edit" << std::endl;
+	std::cout << "full remesh: " << fullMs * 1000.0 / 20 << "us" << std::endl;
+
+	Chunk::DeleteShared();
+	return same ? 0 : 1;
+}
+
+int Benchmark::RegionEdit()
+{
+	// the edit path runs through VoxelScene, which needs a context for its buffers and mesh swaps. nothing gets shown
+	glfwInit();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	Window window(64, 64);
+	if (window.Init() < 0 || GX::GLADInit() < 0)
+	{
+		glfwTerminate();
+		return -1;
+	}
+
+	int result = 0;
+	{
+		using BlockType = Chunk::BlockType;
+		VoxelScene scene;
+		const glm::vec3 origin(0);
+		const float radius = 20.0f;
+		// on chunk corners, edges and faces, so each sphere covers a few dozen chunks and their borders
+		const glm::vec3 centers[] =
+		{
+			glm::vec3(0, 0, 0),
+			glm::vec3(8, 0, 0),
+			glm::vec3(0, 8, 8),
+			glm::vec3(-16, 4, 16),
+			glm::vec3(16, -8, -4),
+		};
+		const int numCenters = sizeof(centers) / sizeof(centers[0]);
+
+		AABB bounds(centers[0], centers[0]);
+		for (const glm::vec3& center : centers)
+		{
+			bounds.min = glm::min(bounds.min, center);
+			bounds.max = glm::max(bounds.max, center);
+		}
+		bounds = AABB(bounds.min - radius - float(CHUNK_UNIT_SIZE), bounds.max + radius + float(CHUNK_UNIT_SIZE));
+
+		// frames until done() or we give up
+		auto runFrames = [&scene, &origin](const std::function<bool()>& done)
+		{
+			for (int frame = 0; frame < 100000; frame++)
+			{
+				if (done())
+					return true;
+				scene.Update(origin);
+				std::this_thread::yield();
+			}
+			return done();
+		};
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		if (!runFrames([&scene, &bounds]() { return scene.IsRegionLoaded(bounds); }))
+		{
+			std::cout << "terrain around the edits never finished generating" << std::endl;
+			result = 1;
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		std::cout << "terrain loaded in " << std::chrono::duration<double, std::milli>(endTime - startTime).count() << "ms" << std::endl;
+
+		// fill first so the carves have something to take out whatever the terrain is
+		const BlockType types[] = { BlockType::Stone, BlockType::Air };
+		for (int t = 0; t < 2 && result == 0; t++)
+		{
+			const BlockType type = types[t];
+			double editMs = 0;
+			double maxEditMs = 0;
+			double remeshMs = 0;
+			uint chunks = 0;
+			for (const glm::vec3& center : centers)
+			{
+				startTime = std::chrono::high_resolution_clock::now();
+				const bool edited = scene.EditSphere(center, radius, type);
+				auto midTime = std::chrono::high_resolution_clock::now();
+				if (!edited)
+				{
+					std::cout << "sphere reaches past the lod 0 chunks" << std::endl;
+					result = 1;
+					break;
+				}
+				chunks += scene.GetPendingEditChunkCount();
+				if (!runFrames([&scene]() { return !scene.HasPendingEdits(); }))
+				{
+					std::cout << "edits never finished remeshing" << std::endl;
+					result = 1;
+					break;
+				}
+				endTime = std::chrono::high_resolution_clock::now();
+				const double ms = std::chrono::duration<double, std::milli>(midTime - startTime).count();
+				editMs += ms;
+				maxEditMs = std::max(maxEditMs, ms);
+				remeshMs += std::chrono::duration<double, std::milli>(endTime - midTime).count();
+			}
+			if (result != 0)
+				break;
+
+			std::cout << (type == BlockType::Air ? "carve" : "fill") << " radius " << radius << ": EditSphere " << editMs / numCenters << "ms (worst " << maxEditMs << "ms) over "
+				<< float(chunks) / numCenters << " chunks, " << remeshMs / numCenters << "ms until every chunk is remeshed and swapped in" << std::endl;
+
+			// the centers have to be solid after the fills, and after the carves rays out of them cant hit anything inside the radius
+			const glm::vec3 dirs[] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+			uint failures = 0;
+			for (const glm::vec3& center : centers)
+			{
+				for (const glm::vec3& dir : dirs)
+				{
+					VoxelScene::VoxelRayHit hit;
+					const bool hitSomething = scene.RayCast({ center, dir }, hit);
+					const float distance = hitSomething ? glm::length(hit.hitPosition - center) : 0.0f;
+					if (type == BlockType::Air ? (hitSomething && distance < radius - VOXEL_UNIT_SIZE) : !(hitSomething && distance == 0.0f))
+						failures++;
+				}
+			}
+			if (failures)
+			{
+				std::cout << failures << " rays out of the sphere centers didnt see the " << (type == BlockType::Air ? "carve" : "fill") << std::endl;
+				result = 1;
+			}
+		}
+	}
+
+	glfwTerminate();
+	return result;
+}
+
+int Benchmark::Skirts()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	// noise only, we want the skirt path
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	bool& batchSkirtNoise = RenderSettings::Get().batchSkirtNoise;
+	const bool oldBatchSkirtNoise = batchSkirtNoise;
+	uint totalMismatches = 0;
+	for (uint lod = 1; lod <= 6; lod++)
+	{
+		double timeMs[2] = { 0, 0 };
+		size_t quads[2] = { 0, 0 };
+		uint mismatches = 0;
+		uint numChunks = 0;
+		const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+		for (int x = -2; x < 2; x++)
+		{
+			for (int y = -2; y < 2; y++)
+			{
+				for (int z = -2; z < 2; z++)
+				{
+					uint chunkQuads[2];
+					for (int batched = 0; batched < 2; batched++)
+					{
+						batchSkirtNoise = batched;
+						Chunk chunk(glm::vec3(x, y, z) * chunkSize, lod);
+						auto startTime = std::chrono::high_resolution_clock::now();
+						chunk.GenerateVolume(&generators);
+						std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+						timeMs[batched] += time.count();
+						chunkQuads[batched] = chunk.GetQuadCount();
+						quads[batched] += chunkQuads[batched];
+					}
+					mismatches += chunkQuads[0] != chunkQuads[1];
+					numChunks++;
+				}
+			}
+		}
+		std::cout << "lod " << lod << ": per sample " << timeMs[0] / numChunks << "ms, batched " << timeMs[1] / numChunks << "ms per chunk ("
+			<< timeMs[0] / std::max(timeMs[1], 0.001) << "x). quads " << quads[0] << " vs " << quads[1] << ", " << mismatches << " chunks differ" << std::endl;
+		totalMismatches += mismatches;
+	}
+	batchSkirtNoise = oldBatchSkirtNoise;
+
+	Chunk::DeleteShared();
+	return totalMismatches == 0 ? 0 : 1;
+}
+
+int Benchmark::Classify()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	std::cout << "lipschitz estimates from the terrain graph: density " << generators.steps[Chunk::Noise_Density].lipschitz
+		<< ", cave " << generators.steps[Chunk::Noise_Cave].lipschitz << std::endl;
+	// tall columns like the octree makes, most of it is sky or underground
+	const int COLUMN_HEIGHT = 16;
+	uint mismatches = 0;
+	for (uint lod = 0; lod <= 4; lod++)
+	{
+		const GenerationComparison comparison = CompareGeneration(generators, lod, glm::i32vec3(-1, -COLUMN_HEIGHT / 2, -1), glm::i32vec3(1, COLUMN_HEIGHT / 2, 1),
+			[&params](bool classify) { params.classifyVolumes = classify; });
+		std::cout << "lod " << lod << ": full " << comparison.timeMs[0] / comparison.numChunks << "ms, classified " << comparison.timeMs[1] / comparison.numChunks
+			<< "ms per chunk (" << comparison.timeMs[0] / std::max(comparison.timeMs[1], 0.001) << "x). " << comparison.emptyChunks << "/" << comparison.numChunks
+			<< " empty, " << comparison.mismatches << " chunks differ" << std::endl;
+		mismatches += comparison.mismatches;
+	}
+
+	Chunk::DeleteShared();
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmark::Adaptive()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	// every chunk goes through the density grid
+	params.classifyVolumes = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	auto isSolid = [](const Chunk& chunk, uint x, uint y, uint z)
+	{
+		return !chunk.IsEmpty() && chunk.GetBlockType(x, y, z) != Chunk::BlockType::Air;
+	};
+
+	const int COLUMN_HEIGHT = 4;
+	for (uint lod = 0; lod <= 4; lod++)
+	{
+		double timeMs[2] = { 0, 0 };
+		uint quads[2] = { 0, 0 };
+		uint64_t flipped = 0;
+		uint64_t numVoxels = 0;
+		uint numChunks = 0;
+		const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+		for (int x = -2; x < 2; x++)
+		{
+			for (int z = -2; z < 2; z++)
+			{
+				for (int y = -COLUMN_HEIGHT / 2; y < COLUMN_HEIGHT / 2; y++)
+				{
+					Chunk chunks[2] = { Chunk(glm::vec3(x, y, z) * chunkSize, lod), Chunk(glm::vec3(x, y, z) * chunkSize, lod) };
+					for (int adaptive = 0; adaptive < 2; adaptive++)
+					{
+						params.adaptiveDensity = adaptive;
+						auto startTime = std::chrono::high_resolution_clock::now();
+						chunks[adaptive].GenerateVolume(&generators);
+						std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+						timeMs[adaptive] += time.count();
+						quads[adaptive] += chunks[adaptive].GetQuadCount();
+					}
+
+					for (uint vx = 0; vx < CHUNK_VOXEL_SIZE; vx++)
+						for (uint vy = 0; vy < CHUNK_VOXEL_SIZE; vy++)
+							for (uint vz = 0; vz < CHUNK_VOXEL_SIZE; vz++)
+								flipped += isSolid(chunks[0], vx, vy, vz) != isSolid(chunks[1], vx, vy, vz);
+					numVoxels += CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE;
+					numChunks++;
+				}
+			}
+		}
+		std::cout << "lod " << lod << ": full " << timeMs[0] / numChunks << "ms, adaptive " << timeMs[1] / numChunks << "ms per chunk ("
+			<< timeMs[0] / std::max(timeMs[1], 0.001) << "x). quads " << quads[0] << " vs " << quads[1] << ", "
+			<< flipped << "/" << numVoxels << " voxels flipped (" << 100.0 * double(flipped) / double(numVoxels) << "%)" << std::endl;
+	}
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::ColumnNoise()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	// chunks the classification skips never get to the 2d noise
+	params.classifyVolumes = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	bool& cacheColumnNoise = RenderSettings::Get().cacheColumnNoise;
+	const bool oldCacheColumnNoise = cacheColumnNoise;
+	NoiseColumnCache& cache = Chunk::GetNoiseColumnCache();
+	const int COLUMN_HEIGHT = 8;
+	uint mismatches = 0;
+	for (uint lod = 0; lod <= 4; lod++)
+	{
+		cache.Clear();
+		const GenerationComparison comparison = CompareGeneration(generators, lod, glm::i32vec3(-2, -COLUMN_HEIGHT / 2, -2), glm::i32vec3(2, COLUMN_HEIGHT / 2, 2),
+			[&cacheColumnNoise](bool cached) { cacheColumnNoise = cached; });
+		std::cout << "lod " << lod << ": uncached " << comparison.timeMs[0] / comparison.numChunks << "ms, cached " << comparison.timeMs[1] / comparison.numChunks
+			<< "ms per chunk (" << comparison.timeMs[0] / std::max(comparison.timeMs[1], 0.001) << "x). " << cache.GetHits() << " hits, " << cache.GetMisses()
+			<< " misses, " << comparison.mismatches << " chunks differ" << std::endl;
+		mismatches += comparison.mismatches;
+	}
+	cacheColumnNoise = oldCacheColumnNoise;
+
+	Chunk::DeleteShared();
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmark::Terrain()
+{
+	ThreadPool threadPool;
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	params.classifyVolumes = false;
+	InitChunks(params, &threadPool);
+
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+	std::chrono::duration<double, std::milli> compileTime = std::chrono::high_resolution_clock::now() - compileStart;
+	uint prunedSteps = 0;
+	for (const Chunk::ChunkNoiseGenerators::Step& step : generators.steps)
+		prunedSteps += step.IsPruned(0);
+	std::cout << TerrainGraph::GetPath() << " compiled in " << compileTime.count() << "ms, " << prunedSteps << "/" << Chunk::Num_NoiseOutputs
+		<< " steps pruned at lod 0, " << threadPool.GetNumThreads() << " pool threads" << std::endl;
+
+	bool& parallelNoiseGrids = RenderSettings::Get().parallelNoiseGrids;
+	bool& cacheColumnNoise = RenderSettings::Get().cacheColumnNoise;
+	const bool oldParallelNoiseGrids = parallelNoiseGrids;
+	const bool oldCacheColumnNoise = cacheColumnNoise;
+	// every chunk runs every step
+	cacheColumnNoise = false;
+	const int COLUMN_HEIGHT = 4;
+	uint mismatches = 0;
+	for (uint lod = 0; lod <= 4; lod++)
+	{
+		const GenerationComparison comparison = CompareGeneration(generators, lod, glm::i32vec3(-2, -COLUMN_HEIGHT / 2, -2), glm::i32vec3(2, COLUMN_HEIGHT / 2, 2),
+			[&parallelNoiseGrids](bool parallel) { parallelNoiseGrids = parallel; });
+		std::cout << "lod " << lod << ": serial " << comparison.timeMs[0] / comparison.numChunks << "ms, parallel " << comparison.timeMs[1] / comparison.numChunks
+			<< "ms per chunk (" << comparison.timeMs[0] / std::max(comparison.timeMs[1], 0.001) << "x). " << comparison.mismatches << " chunks differ" << std::endl;
+		mismatches += comparison.mismatches;
+	}
+	parallelNoiseGrids = oldParallelNoiseGrids;
+	cacheColumnNoise = oldCacheColumnNoise;
+
+	Chunk::DeleteShared();
+	return mismatches == 0 ? 0 : 1;
+}
+
+// binary rgb, rows top to bottom
+static void WritePPM(const std::string& path, int width, int height, const std::vector<uint8_t>& rgb)
+{
+	std::ofstream file(path, std::ios::binary);
+	file << "P6\n" << width << " " << height << "\n255\n";
+	file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+	if (!file)
+		std::cout << "couldnt write " << path << std::endl;
+}
+
+static glm::vec3 GetImageColor(Chunk::BlockType block)
+{
+	switch (block)
+	{
+	case Chunk::BlockType::Dirt:
+		return { 0.7f, 0.39f, 0.11f };
+	case Chunk::BlockType::Grass:
+		return { 0.0f, 0.8f, 0.1f };
+	case Chunk::BlockType::Stone:
+		return { 0.7f, 0.7f, 0.7f };
+	case Chunk::BlockType::Sand:
+		return { 0.9f, 0.8f, 0.5f };
+	case Chunk::BlockType::Blue:
+		return { 0.1f, 0.3f, 0.9f };
+	default:
+		return { 0, 0, 0 };
+	}
+}
+
+int Benchmark::LODImages()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	// nothing resident to downsample from
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	Chunk::ChunkGenParams profiles[2] = { params, params };
+	profiles[0].caveMaxLOD = profiles[0].caveCoarseLOD = profiles[0].biomeMaxLOD = profiles[0].dirtMaxLOD = INT_MAX;
+	const char* profileNames[2] = { "full", "profile" };
+
+	const int CHUNKS_XZ = 4;
+	const int CHUNKS_Y = 8;
+	const int SIZE_XZ = CHUNKS_XZ * CHUNK_VOXEL_SIZE;
+	const int SIZE_Y = CHUNKS_Y * CHUNK_VOXEL_SIZE;
+	for (uint lod = 2; lod <= 6; lod++)
+	{
+		const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+		std::vector<uint8_t> images[2][2];
+		double timeMs[2] = { 0, 0 };
+		for (int profile = 0; profile < 2; profile++)
+		{
+			params = profiles[profile];
+			// biome grids come out different between profiles but share a column key
+			Chunk::GetNoiseColumnCache().Clear();
+			std::vector<std::unique_ptr<Chunk>> chunks;
+			for (int x = 0; x < CHUNKS_XZ; x++)
+			{
+				for (int y = 0; y < CHUNKS_Y; y++)
+				{
+					for (int z = 0; z < CHUNKS_XZ; z++)
+					{
+						chunks.push_back(std::make_unique<Chunk>(glm::vec3(x - CHUNKS_XZ / 2, y - CHUNKS_Y / 2, z - CHUNKS_XZ / 2) * chunkSize, lod));
+						auto startTime = std::chrono::high_resolution_clock::now();
+						chunks.back()->GenerateVolume(&generators);
+						std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+						timeMs[profile] += time.count();
+					}
+				}
+			}
+			auto getBlock = [&](int x, int y, int z)
+			{
+				const Chunk& chunk = *chunks[((x / CHUNK_VOXEL_SIZE) * CHUNKS_Y + y / CHUNK_VOXEL_SIZE) * CHUNKS_XZ + z / CHUNK_VOXEL_SIZE];
+				return chunk.IsEmpty() ? Chunk::BlockType::Air : chunk.GetBlockType(x % CHUNK_VOXEL_SIZE, y % CHUNK_VOXEL_SIZE, z % CHUNK_VOXEL_SIZE);
+			};
+			auto writePixel = [](std::vector<uint8_t>& image, const glm::vec3& color)
+			{
+				for (int c = 0; c < 3; c++)
+					image.push_back(uint8_t(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f));
+			};
+
+			// top down, first solid voxel shaded by height
+			std::vector<uint8_t>& top = images[profile][0];
+			for (int z = 0; z < SIZE_XZ; z++)
+			{
+				for (int x = 0; x < SIZE_XZ; x++)
+				{
+					glm::vec3 color(0);
+					for (int y = SIZE_Y - 1; y >= 0; y--)
+					{
+						const Chunk::BlockType block = getBlock(x, y, z);
+						if (block != Chunk::BlockType::Air)
+						{
+							color = GetImageColor(block) * (0.3f + 0.7f * float(y) / SIZE_Y);
+							break;
+						}
+					}
+					writePixel(top, color);
+				}
+			}
+			// side on from -z, first solid voxel shaded by depth. this is the far silhouette
+			std::vector<uint8_t>& side = images[profile][1];
+			for (int y = SIZE_Y - 1; y >= 0; y--)
+			{
+				for (int x = 0; x < SIZE_XZ; x++)
+				{
+					glm::vec3 color(0);
+					for (int z = 0; z < SIZE_XZ; z++)
+					{
+						const Chunk::BlockType block = getBlock(x, y, z);
+						if (block != Chunk::BlockType::Air)
+						{
+							color = GetImageColor(block) * (1.0f - 0.7f * float(z) / SIZE_XZ);
+							break;
+						}
+					}
+					writePixel(side, color);
+				}
+			}
+		}
+
+		const char* viewNames[2] = { "top", "side" };
+		const int widths[2] = { SIZE_XZ, SIZE_XZ };
+		const int heights[2] = { SIZE_XZ, SIZE_Y };
+		uint differing[2] = { 0, 0 };
+		for (int view = 0; view < 2; view++)
+		{
+			const std::string prefix = "lod" + std::to_string(lod) + "_" + viewNames[view] + "_";
+			for (int profile = 0; profile < 2; profile++)
+				WritePPM(prefix + profileNames[profile] + ".ppm", widths[view], heights[view], images[profile][view]);
+
+			// differing pixels in red over a dimmed full image
+			const std::vector<uint8_t>& full = images[0][view];
+			const std::vector<uint8_t>& profiled = images[1][view];
+			std::vector<uint8_t> diff(full.size());
+			for (size_t i = 0; i < full.size(); i += 3)
+			{
+				const bool same = full[i] == profiled[i] && full[i + 1] == profiled[i + 1] && full[i + 2] == profiled[i + 2];
+				differing[view] += !same;
+				diff[i] = same ? full[i] / 4 : 255;
+				diff[i + 1] = same ? full[i + 1] / 4 : 0;
+				diff[i + 2] = same ? full[i + 2] / 4 : 0;
+			}
+			WritePPM(prefix + "diff.ppm", widths[view], heights[view], diff);
+		}
+
+		const uint numChunks = CHUNKS_XZ * CHUNKS_XZ * CHUNKS_Y;
+		std::cout << "lod " << lod << ": full " << timeMs[0] / numChunks << "ms, profile " << timeMs[1] / numChunks << "ms per chunk ("
+			<< timeMs[0] / std::max(timeMs[1], 0.001) << "x). " << differing[0] << "/" << SIZE_XZ * SIZE_XZ << " top pixels and "
+			<< differing[1] << "/" << SIZE_XZ * SIZE_Y << " side pixels differ" << std::endl;
+	}
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::Slabs()
+{
+	ThreadPool threadPool;
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params, &threadPool);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	RenderSettings& settings = RenderSettings::Get();
+	const int oldGenerationSlabs = settings.generationSlabs;
+	const bool oldSplitMeshSweeps = settings.splitMeshSweeps;
+	const bool oldCacheColumnNoise = settings.cacheColumnNoise;
+	settings.cacheColumnNoise = false;
+	std::cout << threadPool.GetNumThreads() << " pool threads" << std::endl;
+	uint mismatches = 0;
+	for (int slabs : { 2, 4, 8 })
+	{
+		// around the surface, where lod 0 chunks actually have something in them
+		const GenerationComparison comparison = CompareGeneration(generators, 0, glm::i32vec3(-2), glm::i32vec3(2), [&settings, slabs](bool split)
+			{
+				settings.generationSlabs = split ? slabs : 1;
+				settings.splitMeshSweeps = split;
+			});
+		std::cout << slabs << " slabs: one job " << comparison.timeMs[0] / comparison.numChunks << "ms, split " << comparison.timeMs[1] / comparison.numChunks
+			<< "ms per chunk (" << comparison.timeMs[0] / std::max(comparison.timeMs[1], 0.001) << "x). " << comparison.mismatches << " chunks differ" << std::endl;
+		mismatches += comparison.mismatches;
+	}
+	settings.generationSlabs = oldGenerationSlabs;
+	settings.splitMeshSweeps = oldSplitMeshSweeps;
+	settings.cacheColumnNoise = oldCacheColumnNoise;
+
+	Chunk::DeleteShared();
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmark::Fused()
+{
+	ThreadPool threadPool;
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params, &threadPool);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	RenderSettings& settings = RenderSettings::Get();
+	const bool oldFusedMeshing = settings.fusedMeshing;
+	const bool oldCacheColumnNoise = settings.cacheColumnNoise;
+	settings.cacheColumnNoise = false;
+	uint mismatches = 0;
+	for (uint lod : { 0u, 2u })
+	{
+		const GenerationComparison comparison = CompareGeneration(generators, lod, glm::i32vec3(-2), glm::i32vec3(2),
+			[&settings](bool fused) { settings.fusedMeshing = fused; });
+		std::cout << "lod " << lod << ": volume then mesh " << comparison.timeMs[0] / comparison.numChunks << "ms, fused " << comparison.timeMs[1] / comparison.numChunks
+			<< "ms per chunk (" << comparison.timeMs[0] / std::max(comparison.timeMs[1], 0.001) << "x). " << comparison.usedBytes << " mesh bytes, allocated "
+			<< comparison.allocatedBytes[0] << " vs " << comparison.allocatedBytes[1] << ". " << comparison.mismatches << " chunks differ" << std::endl;
+		mismatches += comparison.mismatches;
+	}
+	settings.fusedMeshing = oldFusedMeshing;
+	settings.cacheColumnNoise = oldCacheColumnNoise;
+
+	Chunk::DeleteShared();
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmark::MeshMemory()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	// a shell of each lod around the origin, roughly what the octree keeps around the player
+	constexpr uint MAX_LOD = 4;
+	constexpr int CHUNKS_PER_AXIS = 4;
+	size_t usedBytes = 0;
+	size_t grownBytes = 0;
+	uint numMeshedChunks = 0;
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	for (uint lod = 0; lod <= MAX_LOD; lod++)
+	{
+		const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+		for (int x = -CHUNKS_PER_AXIS / 2; x < CHUNKS_PER_AXIS / 2; x++)
+		{
+			for (int y = -CHUNKS_PER_AXIS / 2; y < CHUNKS_PER_AXIS / 2; y++)
+			{
+				for (int z = -CHUNKS_PER_AXIS / 2; z < CHUNKS_PER_AXIS / 2; z++)
+				{
+					chunks.push_back(std::make_unique<Chunk>(glm::vec3(x, y, z) * chunkSize, lod));
+					Chunk& chunk = *chunks.back();
+					chunk.GenerateVolume(&generators);
+					const size_t quadCount = chunk.GetQuadCount();
+					if (quadCount == 0)
+						continue;
+					// push_back from empty doubles, and clear() after upload never gave any of it back
+					size_t grownCapacity = 1;
+					while (grownCapacity < quadCount)
+						grownCapacity *= 2;
+					usedBytes += quadCount * sizeof(Chunk::PackedQuad);
+					grownBytes += grownCapacity * sizeof(Chunk::PackedQuad);
+					numMeshedChunks++;
+				}
+			}
+		}
+	}
+	const size_t residentBytes = Chunk::GetResidentQuadBytes();
+	const size_t numChunks = chunks.size();
+	chunks.clear();
+
+	std::cout << numChunks << " chunks, " << numMeshedChunks << " with a mesh, " << usedBytes << " bytes of quads" << std::endl;
+	std::cout << "waiting on upload: " << residentBytes << " bytes resident, push_back growth would have been " << grownBytes << std::endl;
+	std::cout << "after upload: uploading frees all of it, push_back growth kept all " << grownBytes << std::endl;
+	std::cout << "after the chunks are gone: " << Chunk::GetResidentQuadBytes() << " bytes resident" << std::endl;
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::Queues()
+{
+	constexpr uint NUM_PRODUCERS = 32;
+	constexpr uint PUSHES_PER_PRODUCER = 20000;
+	constexpr uint64_t TOTAL_PUSHES = uint64_t(NUM_PRODUCERS) * PUSHES_PER_PRODUCER;
+	// every value gets pushed once, so the drained values have to add up to this
+	constexpr uint64_t EXPECTED_SUM = TOTAL_PUSHES * (TOTAL_PUSHES - 1) / 2;
+
+	// push(value) from the producers, drain(out) appends everything pushed so far on the consumer
+	auto run = [&](const char* name, const std::function<void(uint64_t)>& push, const std::function<void(std::vector<uint64_t>&)>& drain)
+	{
+		std::atomic<bool> start = false;
+		std::vector<std::thread> producers;
+		for (uint p = 0; p < NUM_PRODUCERS; p++)
+		{
+			producers.emplace_back([&, p]()
+			{
+				while (!start.load())
+					std::this_thread::yield();
+				for (uint i = 0; i < PUSHES_PER_PRODUCER; i++)
+					push(uint64_t(p) * PUSHES_PER_PRODUCER + i);
+			});
+		}
+
+		std::vector<uint64_t> drained;
+		drained.reserve(TOTAL_PUSHES);
+		uint drains = 0;
+		auto startTime = std::chrono::high_resolution_clock::now();
+		start = true;
+		// like the main thread, drain whatever is there and go do something else for a bit
+		while (drained.size() < TOTAL_PUSHES)
+		{
+			drain(drained);
+			drains++;
+			std::this_thread::yield();
+		}
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+		for (std::thread& producer : producers)
+			producer.join();
+
+		uint64_t sum = 0;
+		for (uint64_t value : drained)
+			sum += value;
+		std::cout << name << ": " << time.count() << "ms, " << TOTAL_PUSHES / time.count() / 1000.0 << "M pushes/s, "
+			<< drains << " drains" << (sum == EXPECTED_SUM && drained.size() == TOTAL_PUSHES ? "" : ", LOST OR DUPLICATED PUSHES") << std::endl;
+	};
+
+	std::cout << NUM_PRODUCERS << " producers, " << PUSHES_PER_PRODUCER << " pushes each, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	std::mutex dequeMutex;
+	std::deque<uint64_t> deque;
+	run("mutex + deque", [&](uint64_t value)
+		{
+			std::lock_guard lock(dequeMutex);
+			deque.push_back(value);
+		},
+		[&](std::vector<uint64_t>& out)
+		{
+			std::lock_guard lock(dequeMutex);
+			out.insert(out.end(), deque.begin(), deque.end());
+			deque.clear();
+		});
+
+	std::mutex listMutex;
+	std::list<uint64_t> list;
+	run("mutex + list", [&](uint64_t value)
+		{
+			std::lock_guard lock(listMutex);
+			list.push_back(value);
+		},
+		[&](std::vector<uint64_t>& out)
+		{
+			std::list<uint64_t> taken;
+			{
+				std::lock_guard lock(listMutex);
+				taken.splice(taken.end(), list);
+			}
+			out.insert(out.end(), taken.begin(), taken.end());
+		});
+
+	MPSCQueue<uint64_t> queue;
+	run("MPSCQueue", [&](uint64_t value) { queue.Push(value); }, [&](std::vector<uint64_t>& out) { queue.Drain(out); });
+
+	return 0;
+}
+
+int Benchmark::ChunkChurn()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	// Player::m_speed, at 60 frames a second. the first frames build the tree and arent counted
+	constexpr float FLIGHT_SPEED = 50.0f;
+	constexpr int FRAMES_PER_SECOND = 60;
+	constexpr int WARMUP_FRAMES = 60;
+	constexpr int FLIGHT_FRAMES = FRAMES_PER_SECOND * 5;
+	const glm::vec3 velocity = glm::normalize(glm::vec3(1.0f, 0.1f, 0.5f)) * FLIGHT_SPEED / float(FRAMES_PER_SECOND);
+
+	auto run = [&](const char* name, bool pooled)
+	{
+		Octree octree;
+		EpochReclaimer<Chunk> reclaimer;
+		uint64_t deletes = 0;
+		if (pooled)
+			reclaimer.SetFreeFunction([&octree](Chunk* chunk) { octree.GetChunkPool().Free(chunk); });
+		else
+			reclaimer.SetFreeFunction([&deletes](Chunk* chunk) { deletes++; delete chunk; });
+
+		std::vector<Chunk*> newChunks;
+		std::vector<Chunk*> leafChunks;
+		std::vector<Chunk*> retiredChunks;
+		ChunkPool::Stats startStats;
+		uint64_t startDeletes = 0;
+		uint64_t generated = 0;
+		double generateMs = 0;
+		glm::vec3 position(0.0f, 40.0f, 0.0f);
+		for (int frame = 0; frame < WARMUP_FRAMES + FLIGHT_FRAMES; frame++)
+		{
+			if (frame == WARMUP_FRAMES)
+			{
+				startStats = octree.GetChunkPool().GetStats();
+				startDeletes = deletes;
+				generated = 0;
+				generateMs = 0;
+			}
+
+			newChunks.clear();
+			leafChunks.clear();
+			octree.GenerateFromPosition(position, newChunks, leafChunks, retiredChunks);
+			// generated inline, so everything is done by the next frame
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (Chunk* chunk : newChunks)
+				chunk->GenerateVolume(&generators);
+			generateMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+			generated += newChunks.size();
+
+			for (Chunk* chunk : retiredChunks)
+			{
+				chunk->SetRetired();
+				reclaimer.Retire(chunk);
+			}
+			retiredChunks.clear();
+			reclaimer.Collect();
+			position += velocity;
+		}
+
+		const ChunkPool::Stats& stats = octree.GetChunkPool().GetStats();
+		const double seconds = double(FLIGHT_FRAMES) / FRAMES_PER_SECOND;
+		std::cout << name << ": " << generated << " chunks generated in " << seconds << "s of flight, "
+			<< (stats.allocations - startStats.allocations) / seconds << " allocations/s, "
+			<< (stats.reuses - startStats.reuses) / seconds << " reuses/s, "
+			<< (deletes - startDeletes + stats.deletes - startStats.deletes) / seconds << " deletes/s, "
+			<< octree.GetChunkPool().GetFreeCount() << " pooled at the end, generation " << generateMs << "ms" << std::endl;
+
+		octree.Clear(retiredChunks);
+		for (Chunk* chunk : retiredChunks)
+			reclaimer.Retire(chunk);
+		reclaimer.FreeAll();
+	};
+
+	run("new/delete", false);
+	run("ChunkPool", true);
+
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::ChunkSize()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	constexpr uint MAX_LOD = 4;
+	constexpr int CHUNKS_PER_AXIS = 4;
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	uint numVolumes = 0;
+	for (uint lod = 0; lod <= MAX_LOD; lod++)
+	{
+		const float chunkSize = float(CHUNK_UNIT_SIZE << lod);
+		for (int x = -CHUNKS_PER_AXIS / 2; x < CHUNKS_PER_AXIS / 2; x++)
+		{
+			for (int y = -CHUNKS_PER_AXIS / 2; y < CHUNKS_PER_AXIS / 2; y++)
+			{
+				for (int z = -CHUNKS_PER_AXIS / 2; z < CHUNKS_PER_AXIS / 2; z++)
+				{
+					chunks.push_back(std::make_unique<Chunk>(glm::vec3(x, y, z) * chunkSize, lod));
+					chunks.back()->GenerateVolume(&generators);
+					// all air chunks give their volume back
+					if (!chunks.back()->IsEmpty())
+						numVolumes++;
+				}
+			}
+		}
+	}
+
+	const size_t numChunks = chunks.size();
+	const size_t volumeBytes = size_t(numVolumes) * sizeof(Chunk::VoxelData);
+	std::cout << "sizeof(Chunk) " << sizeof(Chunk) << " bytes, sizeof(VoxelData) " << sizeof(Chunk::VoxelData) << " bytes" << std::endl;
+	std::cout << numChunks << " chunks, " << numVolumes << " holding a volume. after upload "
+		<< double(numChunks * sizeof(Chunk) + volumeBytes) / numChunks << " bytes per chunk, "
+		<< double(numChunks * sizeof(Chunk)) / numChunks << " of it not the volume" << std::endl;
+
+	chunks.clear();
+	Chunk::DeleteShared();
+	return 0;
+}
+
+int Benchmark::Collision()
+{
+	Chunk::ChunkGenParams params;
+	params.m_debugFlatWorld = false;
+	params.downsampleLODs = false;
+	InitChunks(params);
+
+	Chunk::ChunkNoiseGenerators generators;
+	VoxelScene::CreateNoiseGenerators(generators);
+
+	// a block of lod 0 chunks around the origin, standing in for the octree
+	constexpr int CHUNKS_PER_AXIS = 6;
+	std::unordered_map<glm::i32vec3, std::unique_ptr<Chunk>> chunks;
+	for (int x = -CHUNKS_PER_AXIS / 2; x < CHUNKS_PER_AXIS / 2; x++)
+	{
+		for (int y = -CHUNKS_PER_AXIS / 2; y < CHUNKS_PER_AXIS / 2; y++)
+		{
+			for (int z = -CHUNKS_PER_AXIS / 2; z < CHUNKS_PER_AXIS / 2; z++)
+			{
+				std::unique_ptr<Chunk>& chunk = chunks[glm::i32vec3(x, y, z)];
+				chunk = std::make_unique<Chunk>(glm::vec3(x, y, z) * float(CHUNK_UNIT_SIZE), 0);
+				chunk->GenerateVolume(&generators);
+			}
+		}
+	}
+	auto getChunk = [&chunks](const glm::i32vec3& chunkCoord) -> const Chunk*
+	{
+		auto it = chunks.find(chunkCoord);
+		return it != chunks.end() ? it->second.get() : nullptr;
+	};
+	auto getVoxel = [&getChunk](const glm::i32vec3& voxel, bool& loaded)
+	{
+		const glm::i32vec3 chunkCoord = glm::i32vec3(glm::floor(glm::vec3(voxel) / float(CHUNK_VOXEL_SIZE)));
+		const Chunk* chunk = getChunk(chunkCoord);
+		loaded = chunk != nullptr;
+		return loaded && chunk->VoxelIsCollideable(voxel - chunkCoord * CHUNK_VOXEL_SIZE);
+	};
+	// any collideable voxel the box properly overlaps, touching doesnt count
+	auto overlapsVoxels = [&getVoxel](const AABB& box)
+	{
+		const glm::i32vec3 lo = glm::i32vec3(glm::floor(box.min * float(UNIT_VOXEL_RESOLUTION)));
+		const glm::i32vec3 hi = glm::i32vec3(glm::ceil(box.max * float(UNIT_VOXEL_RESOLUTION))) - 1;
+		bool loaded;
+		for (int x = lo.x; x <= hi.x; x++)
+		{
+			for (int y = lo.y; y <= hi.y; y++)
+			{
+				for (int z = lo.z; z <= hi.z; z++)
+				{
+					if (getVoxel({ x, y, z }, loaded))
+						return true;
+				}
+			}
+		}
+		return false;
+	};
+
+	// the way ResolveBoxCollider2 used to do it. a lookup per voxel of the swept box into a heap array,
+	// then every solid voxel tested against the box one axis at a time
+	auto perVoxelSweep = [&getVoxel](const AABB& box, const glm::vec3& delta, glm::vec3& moved, bool hit[3])
+	{
+		moved = glm::vec3(0);
+		hit[0] = hit[1] = hit[2] = false;
+		const glm::i32vec3 lo = glm::i32vec3(glm::floor(glm::min(box.min, box.min + delta) * float(UNIT_VOXEL_RESOLUTION))) - 1;
+		const glm::i32vec3 hi = glm::i32vec3(glm::floor(glm::max(box.max, box.max + delta) * float(UNIT_VOXEL_RESOLUTION))) + 1;
+		const glm::i32vec3 size = hi - lo + 1;
+		bool* solid = new bool[size.x * size.y * size.z];
+		int index = 0;
+		bool loaded = true;
+		for (int x = 0; x < size.x && loaded; x++)
+		{
+			for (int y = 0; y < size.y && loaded; y++)
+			{
+				for (int z = 0; z < size.z && loaded; z++)
+					solid[index++] = getVoxel(lo + glm::i32vec3(x, y, z), loaded);
+			}
+		}
+		if (!loaded)
+		{
+			delete[] solid;
+			return false;
+		}
+
+		AABB current = box;
+		for (int a = 0; a < 3; a++)
+		{
+			if (delta[a] == 0.0f)
+				continue;
+			const int b = (a + 1) % 3;
+			const int c = (a + 2) % 3;
+			float distance = delta[a];
+			index = 0;
+			for (int x = 0; x < size.x; x++)
+			{
+				for (int y = 0; y < size.y; y++)
+				{
+					for (int z = 0; z < size.z; z++)
+					{
+						if (!solid[index++])
+							continue;
+						const glm::vec3 voxelMin = glm::vec3(lo + glm::i32vec3(x, y, z)) * VOXEL_UNIT_SIZE;
+						const glm::vec3 voxelMax = voxelMin + VOXEL_UNIT_SIZE;
+						if (voxelMax[b] <= current.min[b] || voxelMin[b] >= current.max[b] || voxelMax[c] <= current.min[c] || voxelMin[c] >= current.max[c])
+							continue;
+						if (delta[a] > 0.0f && voxelMin[a] >= current.max[a] && voxelMin[a] - current.max[a] < distance)
+							distance = glm::max(voxelMin[a] - current.max[a] - VoxelCollision::SKIN, 0.0f);
+						else if (delta[a] < 0.0f && voxelMax[a] <= current.min[a] && voxelMax[a] - current.min[a] > distance)
+							distance = glm::min(voxelMax[a] - current.min[a] + VoxelCollision::SKIN, 0.0f);
+						else
+							continue;
+						hit[a] = true;
+					}
+				}
+			}
+			current.min[a] += distance;
+			current.max[a] += distance;
+			moved[a] += distance;
+		}
+		delete[] solid;
+		return true;
+	};
+
+	constexpr int NUM_COLLIDERS = 400;
+	constexpr int NUM_FRAMES = 300;
+	constexpr float TIME_DELTA = 16.0f;
+	const glm::vec3 playerSize = glm::vec3(2, 4, 2) * VOXEL_UNIT_SIZE;
+	const float spawnExtent = float(CHUNK_UNIT_SIZE * CHUNKS_PER_AXIS / 2) - 4.0f;
+
+	VoxelCollision collision;
+	const char* names[2] = { "VoxelCollision", "per voxel" };
+	for (int method = 0; method < 2; method++)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> spawn(-spawnExtent, spawnExtent);
+		std::uniform_real_distribution<float> walk(-8.0f, 8.0f);
+		auto respawn = [&](AABB& box, glm::vec3& velocity)
+		{
+			// somewhere in the air, dropping onto the terrain
+			do
+			{
+				const glm::vec3 center(spawn(random), spawnExtent, spawn(random));
+				box = AABB(center - playerSize * 0.5f, center + playerSize * 0.5f);
+			} while (overlapsVoxels(box));
+			velocity = glm::vec3(walk(random), 0, walk(random));
+		};
+
+		std::vector<AABB> boxes(NUM_COLLIDERS);
+		std::vector<glm::vec3> velocities(NUM_COLLIDERS);
+		for (int i = 0; i < NUM_COLLIDERS; i++)
+			respawn(boxes[i], velocities[i]);
+
+		double timeMs = 0;
+		uint sweeps = 0;
+		uint hits = 0;
+		uint leftWorld = 0;
+		uint overlaps = 0;
+		for (int frame = 0; frame < NUM_FRAMES; frame++)
+		{
+			for (int i = 0; i < NUM_COLLIDERS; i++)
+			{
+				// wander off in a new direction every second or so
+				if ((frame + i) % 60 == 0)
+				{
+					velocities[i].x = walk(random);
+					velocities[i].z = walk(random);
+				}
+				velocities[i].y -= 75.0f * (TIME_DELTA / 1000.f);
+				const glm::vec3 delta = velocities[i] * (TIME_DELTA / 1000.f);
+
+				glm::vec3 moved;
+				bool hit[3];
+				auto startTime = std::chrono::high_resolution_clock::now();
+				const bool loaded = method == 0 ? collision.Sweep(boxes[i], delta, getChunk, moved, hit) : perVoxelSweep(boxes[i], delta, moved, hit);
+				std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+				timeMs += time.count();
+				sweeps++;
+
+				if (!loaded)
+				{
+					leftWorld++;
+					respawn(boxes[i], velocities[i]);
+					continue;
+				}
+				boxes[i].Translate(moved);
+				for (int a = 0; a < 3; a++)
+				{
+					if (hit[a])
+						velocities[i][a] = 0.0f;
+					hits += hit[a];
+				}
+				overlaps += overlapsVoxels(boxes[i]);
+			}
+		}
+		std::cout << names[method] << ": " << timeMs * 1000.0 / sweeps << "us per sweep, " << timeMs / NUM_FRAMES << "ms per frame for "
+			<< NUM_COLLIDERS << " colliders. " << hits << " axis hits, " << leftWorld << " walked out of the loaded chunks, "
+			<< overlaps << " ended up inside a voxel" << std::endl;
+	}
+
+	chunks.clear();
+	Chunk::DeleteShared();
+	return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// headless measurements that dont need a window or gl context, apart from regionedit which makes a hidden one.
+// run with: GLVoxel --bench <name> [--terrain <file>]
+class Benchmark
+{
+public:
+	// returns the process exit code
+	static int Run(const char* name);
+
+private:
+	// bytes per chunk mesh, packed quads vs the old 4 vertices + 6 shared indices per face
+	static int MeshSize();
+	// worst case volumes for the mesher. mesh size and meshing throughput
+	static int MeshStress();
+	// quad counts and mesh time with ao on and off, ao stops quads merging across differently shaded corners
+	static int MeshAO();
+	// single voxel edits, incremental remesh vs a full one
+	static int Remesh();
+	// radius 20 sphere fills and carves through VoxelScene::EditSphere across chunk corners and edges.
+	// time for the call itself and until every touched chunk is remeshed and swapped in
+	static int RegionEdit();
+	// lod > 0 generation with skirt noise sampled one voxel at a time vs batched
+	static int Skirts();
+	// columns of chunks generated with and without the air/solid classification pass
+	static int Classify();
+	// density sampled every 4th voxel and refined near the surface vs the full grid, time and voxels that flip air/solid
+	static int Adaptive();
+	// columns of stacked chunks with the 2d noise generated per chunk vs once per column
+	static int ColumnNoise();
+	// the loaded terrain graph, noise grids run one after another vs as thread pool sub-jobs. has to come out identical
+	static int Terrain();
+	// renders lod volumes top down and side on with every layer vs the gen params lod profile, writes ppms
+	// of both and where they differ so the far silhouette can be checked by eye
+	static int LODImages();
+	// lod 0 chunk latency as one job vs z slab and mesh axis sub-jobs on the thread pool. has to come out identical
+	static int Slabs();
+	// classification handing the mesher opaque rows vs sweeping every plane of the volume.
+	// time, mesh bytes allocated vs used, has to come out identical
+	static int Fused();
+	// cpu mesh storage over a few lods of the octree around the origin, exact size vs what push_back growth used to leave behind
+	static int MeshMemory();
+	// 32 threads reporting chunk completions to a draining main thread, MPSCQueue vs the mutex guarded deque and list
+	static int Queues();
+	// flying through the octree at player speed, chunk allocations per second with retired chunks recycled by ChunkPool vs deleted
+	static int ChunkChurn();
+	// bytes each chunk keeps around once its mesh is on the gpu, the object itself plus its volume, over a few lods around the origin
+	static int ChunkSize();
+	// hundreds of player sized boxes walking and falling over lod 0 terrain, VoxelCollision vs a chunk lookup and swept test per voxel
+	static int Collision();
+};
@@ -3,7 +3,9 @@
 #include <iostream>
 #include "glm/gtc/noise.hpp"
 #include <algorithm>
+#include <limits>
 #include "MemPooler.h"
+#include "NoiseColumnCache.h"
 //#include <Tracy.hpp>
 
 float smoothstep(float edge0, float edge1, float x) {
@@ -17,22 +19,25 @@ static std::unordered_map<std::thread::id, int> s_threadIDs;
 
 static std::function<void(Chunk*)> s_generateMeshCallback;
 static std::function<void(Chunk*)> s_renderListCallback;
+static std::function<void(Chunk*)> s_volumeGeneratedCallback;
+static Chunk::ParallelForFunction s_parallelFor;
 
 static const Chunk::ChunkGenParams* s_chunkGenParams = nullptr;
 
 // can solve for this inital value
 static MemPooler<Chunk::VoxelData> s_memPool(30000);
-
-static std::vector<uint> s_chunkIndices;
-uint s_chunkEBO = 0;
+static NoiseColumnCache s_noiseColumnCache;
+// generation meshes waiting on their upload, see GetResidentQuadBytes
+static std::atomic<size_t> s_residentQuadBytes = 0;
+// glGenBuffers calls, only ever made on the main thread
+static uint64_t s_bufferCreations = 0;
+static_assert(NoiseColumnCache::GRID_SIZE == Chunk::INT_CHUNK_VOXEL_SIZE * Chunk::INT_CHUNK_VOXEL_SIZE);
 
 Chunk::ScratchpadMemoryLayout* Chunk::s_scratchpadMemory;
 
 Chunk::Chunk()
 {
-	// can bulk generate these from our voxelscene when we create a bunch of chunks.
-	glGenBuffers(1, &m_VBO);
-	glGenBuffers(1, &m_EBO);
+	// buffers are created on first upload so chunks can be built and meshed without a GL context
 }
 
 Chunk::Chunk(
@@ -47,22 +52,33 @@ Chunk::Chunk(
 
 Chunk::~Chunk()
 {
-	glDeleteBuffers(1, &m_VBO);
-	glDeleteBuffers(1, &m_EBO);
+	if (m_VBO)
+		glDeleteBuffers(1, &m_VBO);
 
+	ReleaseLODChildren();
 	s_memPool.Free(m_voxelData);
+	ReleaseQuads();
 }
 
+// back to how a new chunk starts, except m_VBO and its capacity which the next mesh can reuse
 void Chunk::ReleaseResources()
 {
-	for (uint i = 0; i < BlockFace::NumFaces; i++)
-		m_neighbors[i] = 0;
-
-	m_vertices.clear();
-	//m_indices.clear();
-
-	m_vertexCount = 0;
-	m_indexCount = 0;
+	// a parent still downsampling us would be reading whatever chunk we get recycled into
+	assert(m_lodParentReaders == 0);
+	ReleaseLODChildren();
+	s_memPool.Free(m_voxelData);
+	m_voxelData = nullptr;
+	ReleaseQuads();
+	m_editableMesh.reset();
+	m_editsPending = false;
+	m_retired = false;
+	m_voxelRowsWritten = false;
+	m_genTime = 0.0;
+	m_visibilityFrame = 0;
+	m_visibilityEntryMask = 0;
+
+	m_quadCount = 0;
+	std::fill(std::begin(m_faceQuadOffsets), std::end(m_faceQuadOffsets), 0);
 
 	m_state = ChunkState::BrandNew;
 	m_neighborGeneratedMask = 0;
@@ -73,6 +89,8 @@ void Chunk::ReleaseResources()
 	m_buffersGenerated = 0;
 	m_empty = 1;
 	m_noGeo = 0;
+	m_needsLODSeam = 0;
+	m_faceConnectivity = ALL_FACES_CONNECTED;
 }
 
 void Chunk::CreateResources(const glm::vec3& chunkPos, uint lod)
@@ -80,19 +98,15 @@ void Chunk::CreateResources(const glm::vec3& chunkPos, uint lod)
 	m_chunkPos = chunkPos;
 	m_LOD = lod;
 	m_scale = float(1u << lod);
-	glm::vec3 worldSpacePos = chunkPos;
-	m_AABB = AABB(worldSpacePos, worldSpacePos + glm::vec3(CHUNK_UNIT_SIZE * m_scale));
-
-	m_modelMat = glm::mat4(1.0f);
-	m_modelMat = glm::translate(m_modelMat, m_chunkPos);
-	m_modelMat = glm::scale(m_modelMat, glm::vec3(float(m_scale / UNIT_VOXEL_RESOLUTION)));
 }
 
 void Chunk::InitShared(
 	std::unordered_map<std::thread::id, int>& threadIDs,
 	std::function<void(Chunk*)> generateMeshCallback,
 	std::function<void(Chunk*)> renderListCallback,
-	const ChunkGenParams* chunkGenParams
+	const ChunkGenParams* chunkGenParams,
+	std::function<void(Chunk*)> volumeGeneratedCallback,
+	ParallelForFunction parallelFor
 )
 {
 	s_threadIDs = threadIDs;
@@ -100,31 +114,20 @@ void Chunk::InitShared(
 
 	s_generateMeshCallback = generateMeshCallback;
 	s_renderListCallback = renderListCallback;
+	s_volumeGeneratedCallback = volumeGeneratedCallback;
+	s_parallelFor = parallelFor;
 
 	s_chunkGenParams = chunkGenParams;
-
-	constexpr uint MAX_FACES = 100000;
-	uint indexCount = MAX_FACES * 6;
-	s_chunkIndices.reserve(indexCount);
-	uint vertexCount = 0;
-	for (uint i = 0; i < MAX_FACES; i++)
-	{
-		for (uint j = 0; j < 6; j++)
-		{
-			s_chunkIndices.push_back(s_indices[j] + vertexCount);
-		}
-		vertexCount += 4;
-	}
-
-	glGenBuffers(1, &s_chunkEBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_chunkEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint), s_chunkIndices.data(), GL_STATIC_DRAW);
 }
 
 void Chunk::DeleteShared()
 {
-	delete s_scratchpadMemory;
-	glDeleteBuffers(1, &s_chunkEBO);
+	delete[] s_scratchpadMemory;
+}
+
+NoiseColumnCache& Chunk::GetNoiseColumnCache()
+{
+	return s_noiseColumnCache;
 }
 
 inline bool BlockIsOpaque(Chunk::BlockType t)
@@ -182,6 +185,32 @@ bool Chunk::VoxelIsCollideable(const glm::i32vec3& index) const
 	}
 }
 
+void Chunk::BuildCollisionRows()
+{
+	for (int x = 0; x < CHUNK_VOXEL_SIZE; x++)
+	{
+		for (int y = 0; y < CHUNK_VOXEL_SIZE; y++)
+		{
+			const BlockType* row = &m_voxelData->m_voxels[x + 1][y + 1][1];
+			uint32_t bits = 0;
+			for (int z = 0; z < CHUNK_VOXEL_SIZE; z++)
+				bits |= uint32_t(IsCollideable(row[z])) << z;
+			m_voxelData->m_collisionRows[x][y] = bits;
+		}
+	}
+}
+
+void Chunk::UpdateCollisionRow(int x, int y, int zBegin, int zEnd, BlockType type)
+{
+	zBegin = std::max(zBegin, 0);
+	zEnd = std::min(zEnd, CHUNK_VOXEL_SIZE - 1);
+	if (x < 0 || x >= CHUNK_VOXEL_SIZE || y < 0 || y >= CHUNK_VOXEL_SIZE || zBegin > zEnd)
+		return;
+	const uint32_t bits = uint32_t((uint64_t(1) << (zEnd + 1)) - 1) & ~uint32_t((uint64_t(1) << zBegin) - 1);
+	uint32_t& row = m_voxelData->m_collisionRows[x][y];
+	row = IsCollideable(type) ? row | bits : row & ~bits;
+}
+
 bool Chunk::VoxelIsCollideableAtWorldPos(const glm::vec3& worldPos) const
 {
 	if (m_empty)
@@ -215,16 +244,19 @@ bool Chunk::ReadyForMeshGeneration() const
 void Chunk::DeleteBlockAtIndex(const glm::i8vec3& index)
 {
 	m_voxelData->m_voxels[index.x + 1][index.y + 1][index.z + 1] = BlockType::Air;
+	UpdateCollisionRow(index.x, index.y, index.z, index.z, BlockType::Air);
 }
 
 void Chunk::DeleteBlockAtInternalIndex(const glm::i8vec3& index)
 {
 	m_voxelData->m_voxels[index.x][index.y][index.z] = BlockType::Air;
+	UpdateCollisionRow(index.x - 1, index.y - 1, index.z - 1, index.z - 1, BlockType::Air);
 }
 
 void Chunk::ReplaceBlockAtIndex(const glm::i8vec3& index, BlockType b)
 {
 	m_voxelData->m_voxels[index.x + 1][index.y + 1][index.z + 1] = b;
+	UpdateCollisionRow(index.x, index.y, index.z, index.z, b);
 }
 
 bool Chunk::Renderable() const 
@@ -232,37 +264,109 @@ bool Chunk::Renderable() const
 	return m_renderable;
 }
 
-void Chunk::Render(RenderSettings::DrawMode drawMode)
+// returns the number of quads drawn
+uint Chunk::Render(RenderSettings::DrawMode drawMode, const glm::vec3& cameraPos)
 {
 	if (!m_meshGenerated)
-		return;
+		return 0;
 
-	//maybe shouldnt be in render?
 	if (!m_buffersGenerated)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-		glBufferData(GL_ARRAY_BUFFER, m_vertexCount * sizeof(uint), (uint*)m_vertices.data(), GL_STATIC_DRAW);
-
-		m_vertices.clear();
-		m_vertices.resize(0);
-		m_buffersGenerated = true;
-		m_state = ChunkState::Done;
+		// VoxelScene uploads us when the frame has budget for it
+		if (RenderSettings::Get().stagedUploads)
+			return 0;
+		UploadMesh();
 	}
-	glBindVertexBuffer(0, m_VBO, 0, sizeof(uint));
-	// this only needs to be bound once
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_chunkEBO);
+	// quads get pulled out of the storage buffer and expanded by gl_VertexID in terrain.vs.glsl
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_VBO);
 
-	glUniformMatrix4fv(0, 1, GL_FALSE, &m_modelMat[0][0]);
+	// terrain.vs.glsl builds the model transform from these
+	glUniform4f(0, m_chunkPos.x, m_chunkPos.y, m_chunkPos.z, m_scale / UNIT_VOXEL_RESOLUTION);
 
 	uint dm = (drawMode == RenderSettings::DrawMode::Triangles ? GL_TRIANGLES : GL_LINES);
-	glDrawElements(dm, m_indexCount, GL_UNSIGNED_INT, 0);
+	if (!RenderSettings::Get().faceDirectionCulling)
+	{
+		glDrawArrays(dm, 0, m_quadCount * 6);
+		return m_quadCount;
+	}
+
+	// a face direction can only be seen if the camera is on its front side of at least part of our bounds.
+	// merge whatever survives into as few ranges as possible
+	GLint firsts[BlockFace::NumFaces];
+	GLsizei counts[BlockFace::NumFaces];
+	GLsizei drawCount = 0;
+	uint drawnQuads = 0;
+	bool extendLastRange = false;
+	const float unitSize = GetUnitSize();
+	for (uint i = 0; i < BlockFace::NumFaces; i++)
+	{
+		const uint faceQuadCount = m_faceQuadOffsets[i + 1] - m_faceQuadOffsets[i];
+		const int axis = i / 2;
+		const bool visible = (i % 2 == 0) ? cameraPos[axis] > m_chunkPos[axis] : cameraPos[axis] < m_chunkPos[axis] + unitSize;
+		if (!visible || faceQuadCount == 0)
+		{
+			extendLastRange = extendLastRange && faceQuadCount == 0;
+			continue;
+		}
+
+		// 6 vertices per quad
+		if (extendLastRange)
+		{
+			counts[drawCount - 1] += faceQuadCount * 6;
+		}
+		else
+		{
+			firsts[drawCount] = m_faceQuadOffsets[i] * 6;
+			counts[drawCount] = faceQuadCount * 6;
+			drawCount++;
+		}
+		extendLastRange = true;
+		drawnQuads += faceQuadCount;
+	}
+	if (drawCount)
+		glMultiDrawArrays(dm, firsts, counts, drawCount);
+	return drawnQuads;
+}
+
+bool Chunk::NeedsUpload() const
+{
+	return m_meshGenerated && !m_buffersGenerated && m_quadCount != 0;
+}
+
+void Chunk::UploadMesh()
+{
+	std::lock_guard lock(m_mutex);
+	// a remesh could have started since NeedsUpload
+	if (!m_meshGenerated || m_buffersGenerated)
+		return;
+
+	if (m_VBO == 0)
+	{
+		glGenBuffers(1, &m_VBO);
+		s_bufferCreations++;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_VBO);
+	// recycled chunks keep their buffer, write into it if the mesh fits without wasting most of it
+	if (m_quadCount <= m_VBOCapacity && m_quadCount * 2 >= m_VBOCapacity)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_quadCount * sizeof(PackedQuad), m_quads.data());
+	}
+	else
+	{
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_quadCount * sizeof(PackedQuad), m_quads.data(), GL_STATIC_DRAW);
+		m_VBOCapacity = m_quadCount;
+	}
+
+	// the gpu has its own copy now
+	ReleaseQuads();
+	m_buffersGenerated = true;
+	m_state = ChunkState::Done;
 }
 
 bool Chunk::UpdateNeighborRef(BlockFace face, Chunk* neighbor)
 {
 	// can we make neighbors atomic too
 	//std::unique_lock lock(m_mutex);
-	m_neighbors[face] = neighbor;
 	if (m_generated)
 	{
 		//lock.unlock();
@@ -271,14 +375,6 @@ bool Chunk::UpdateNeighborRef(BlockFace face, Chunk* neighbor)
 	return false;
 }
 
-bool Chunk::UpdateNeighborRefNewChunk(BlockFace face, Chunk* neighbor)
-{
-	// dont need to lock here since chunk hasnt been submitted to threadpool at this point. 
-	// if we can ever delete a chunk while its being worked on then lock this!
-	m_neighbors[face] = neighbor;
-	return false;
-}
-
 void Chunk::NotifyNeighborOfVolumeGeneration(BlockFace neighbor)
 {
 	//TODO look into atomic load args for these
@@ -311,85 +407,574 @@ void Chunk::GenerateVolume(const ChunkNoiseGenerators* generators)
 {
 	auto startTime = std::chrono::high_resolution_clock::now();
 
+	ScratchpadMemoryLayout& scratchMem = s_scratchpadMemory[s_threadIDs[std::this_thread::get_id()]];
+	scratchMem.opaqueRowsChunk = nullptr;
+	m_voxelRowsWritten = false;
+
 	m_voxelData = s_memPool.New();
-	const float TERRAIN_HEIGHT = s_chunkGenParams->terrainHeight;
-	constexpr float DIRT_HEIGHT = 2.0f;
-	constexpr float FREQUENCY = 1 / 200.f;
+	bool emptyVal;
+	// zooming out, the finer chunks under us are usually still resident and way cheaper to reduce than noise is to sample
+	if (!(s_chunkGenParams->downsampleLODs && GenerateVolumeFromChildren(emptyVal)))
+		emptyVal = GenerateVolumeFromNoise(generators);
+	ReleaseLODChildren();
+
+	m_generated.store(true);
+	m_empty = emptyVal;
+	// can do the same thing with full chunks.
+	if (emptyVal)
+	{
+		s_memPool.Free(m_voxelData);
+		m_voxelData = nullptr;
+	}
+	else
+	{
+		BuildCollisionRows();
+	}
+	// edits made to this part of the world before we existed
+	if (s_volumeGeneratedCallback)
+		s_volumeGeneratedCallback(this);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> time = endTime - startTime;
+	m_genTime += time.count();
+
+	// classification already worked out what the mesher needs while the volume was in cache
+	const bool fused = RenderSettings::Get().fusedMeshing && scratchMem.opaqueRowsChunk == this && !m_voxelRowsWritten;
+	scratchMem.opaqueRowsChunk = nullptr;
+	GenerateMesh(fused ? &scratchMem.opaqueRows : nullptr);
+}
+
+void Chunk::SetLODChildren(Chunk* const children[8])
+{
+	for (uint i = 0; i < 8; i++)
+	{
+		if (children[i] == nullptr)
+			continue;
+		// octree children are ordered with the negative halves on set bits
+		m_lodChildren[i ^ 7u] = children[i];
+		children[i]->m_lodParentReaders++;
+	}
+}
+
+void Chunk::ReleaseLODChildren()
+{
+	for (Chunk*& child : m_lodChildren)
+	{
+		if (child)
+			child->m_lodParentReaders--;
+		child = nullptr;
+	}
+}
+
+bool Chunk::GenerateVolumeFromChildren(bool& empty)
+{
+	ZoneScoped;
+	if (m_LOD == 0)
+		return false;
+
+	static const VoxelData s_airVoxelData;
+	const VoxelData* children[8];
+	for (uint i = 0; i < 8; i++)
+	{
+		if (m_lodChildren[i] == nullptr || !m_lodChildren[i]->m_generated.load())
+			return false;
+		const VoxelData* voxelData = m_lodChildren[i]->m_voxelData;
+		children[i] = voxelData ? voxelData : &s_airVoxelData;
+	}
+
+	// each voxel is solid when at least 4 of the 8 under it are. the type comes from the top layer first,
+	// so the surface keeps its color instead of turning into whatever is under it.
+	// rows are contiguous in z and the loop is branchless so it vectorizes
+	constexpr int HALF = CHUNK_VOXEL_SIZE / 2;
+	bool emptyVal = true;
+	for (int x = 0; x < CHUNK_VOXEL_SIZE; x++)
+	{
+		for (int y = 0; y < CHUNK_VOXEL_SIZE; y++)
+		{
+			for (int oz = 0; oz < 2; oz++)
+			{
+				const VoxelData* child = children[(x / HALF) * 4 + (y / HALF) * 2 + oz];
+				const int cx = (x % HALF) * 2 + 1;
+				const int cy = (y % HALF) * 2 + 1;
+				const BlockType* top0 = &child->m_voxels[cx][cy + 1][1];
+				const BlockType* top1 = &child->m_voxels[cx + 1][cy + 1][1];
+				const BlockType* bottom0 = &child->m_voxels[cx][cy][1];
+				const BlockType* bottom1 = &child->m_voxels[cx + 1][cy][1];
+				BlockType* out = &m_voxelData->m_voxels[x + 1][y + 1][oz * HALF + 1];
+				uint8_t anySolid = 0;
+				for (int z = 0; z < HALF; z++)
+				{
+					const BlockType samples[8] = {
+						top0[z * 2], top0[z * 2 + 1], top1[z * 2], top1[z * 2 + 1],
+						bottom0[z * 2], bottom0[z * 2 + 1], bottom1[z * 2], bottom1[z * 2 + 1]
+					};
+					int solid = 0;
+					BlockType type = BlockType::Air;
+					for (int i = 7; i >= 0; i--)
+					{
+						solid += samples[i] != BlockType::Air;
+						type = samples[i] != BlockType::Air ? samples[i] : type;
+					}
+					out[z] = solid >= 4 ? type : BlockType::Air;
+					anySolid |= solid >= 4;
+				}
+				emptyVal = emptyVal && !anySolid;
+			}
+		}
+	}
+
+	// the border only has the childrens border layer to go on, one child voxel deep instead of two.
+	// voxels on a single face get the skirt rule GenerateVolumeFromNoise uses: any air under them makes them air
+	auto axisSamples = [](int p, int octant[2], int index[2])
+	{
+		if (p == -1)
+		{
+			octant[0] = 0;
+			index[0] = -1;
+			return 1;
+		}
+		if (p == CHUNK_VOXEL_SIZE)
+		{
+			octant[0] = 1;
+			index[0] = CHUNK_VOXEL_SIZE;
+			return 1;
+		}
+		for (int i = 0; i < 2; i++)
+		{
+			octant[i] = (p * 2 + i) / CHUNK_VOXEL_SIZE;
+			index[i] = (p * 2 + i) % CHUNK_VOXEL_SIZE;
+		}
+		return 2;
+	};
+	auto onBorder = [](int p) { return p < 0 || p >= CHUNK_VOXEL_SIZE; };
+	for (int x = -1; x <= CHUNK_VOXEL_SIZE; x++)
+	{
+		for (int y = -1; y <= CHUNK_VOXEL_SIZE; y++)
+		{
+			// rows through the middle only have border voxels at the ends
+			const int zStep = (onBorder(x) || onBorder(y)) ? 1 : CHUNK_VOXEL_SIZE + 1;
+			for (int z = -1; z <= CHUNK_VOXEL_SIZE; z += zStep)
+			{
+				const int borderAxes = onBorder(x) + onBorder(y) + onBorder(z);
+
+				int octantX[2], octantY[2], octantZ[2], indexX[2], indexY[2], indexZ[2];
+				const int countX = axisSamples(x, octantX, indexX);
+				const int countY = axisSamples(y, octantY, indexY);
+				const int countZ = axisSamples(z, octantZ, indexZ);
+				int samples = 0;
+				int solid = 0;
+				BlockType type = BlockType::Air;
+				// top layer first so it wins the type
+				for (int j = countY - 1; j >= 0; j--)
+				{
+					for (int i = 0; i < countX; i++)
+					{
+						for (int k = 0; k < countZ; k++)
+						{
+							const VoxelData* child = children[octantX[i] * 4 + octantY[j] * 2 + octantZ[k]];
+							const BlockType sample = child->m_voxels[indexX[i] + 1][indexY[j] + 1][indexZ[k] + 1];
+							samples++;
+							if (sample != BlockType::Air)
+							{
+								if (type == BlockType::Air)
+									type = sample;
+								solid++;
+							}
+						}
+					}
+				}
+				const bool isSolid = borderAxes == 1 ? solid == samples : solid * 2 >= samples;
+				m_voxelData->m_voxels[x + 1][y + 1][z + 1] = isSolid ? type : BlockType::Air;
+				emptyVal = emptyVal && !isSolid;
+			}
+		}
+	}
+
+	empty = emptyVal;
+	return true;
+}
+
+Chunk::VolumeClass Chunk::ClassifyVolume(const ChunkNoiseGenerators* generators, const glm::ivec3& noiseStartPos, float frequencyScale) const
+{
+	ZoneScoped;
+	// a coarse grid spanning the whole bordered volume. every voxel is within half a cell diagonal of a sample
+	constexpr int SAMPLES = 9;
+	constexpr int COUNT = SAMPLES * SAMPLES * SAMPLES;
+	constexpr float SPACING = float(INT_CHUNK_VOXEL_SIZE - 1) / (SAMPLES - 1);
+	const float maxDistance = 0.5f * SPACING * sqrtf(3.0f);
+
+	float x[COUNT], y[COUNT], z[COUNT], noise[COUNT];
+	// the same positions GenUniformGrid3D would sample at this frequency
+	auto sampleBounds = [&](NoiseOutput output, float frequency, float& margin)
+	{
+		// pruned steps are flat
+		const ChunkNoiseGenerators::Step& step = generators->steps[output];
+		margin = 0.0f;
+		if (IsNoiseStepPruned(generators, output))
+			return FastNoise::OutputMinMax{ step.fill, step.fill };
+		frequency *= step.frequency;
+		int i = 0;
+		for (int sz = 0; sz < SAMPLES; sz++)
+		{
+			for (int sy = 0; sy < SAMPLES; sy++)
+			{
+				for (int sx = 0; sx < SAMPLES; sx++)
+				{
+					x[i] = (noiseStartPos.x + sx * SPACING) * frequency;
+					y[i] = (noiseStartPos.y + sy * SPACING) * frequency;
+					z[i] = (noiseStartPos.z + sz * SPACING) * frequency;
+					i++;
+				}
+			}
+		}
+		margin = step.lipschitz * maxDistance * frequency;
+		return step.generator->GenPositionArray3D(noise, COUNT, x, y, z, 0, 0, 0, step.seed);
+	};
+
+	float margin;
+	const FastNoise::OutputMinMax density = sampleBounds(Noise_Density, frequencyScale, margin);
+	// positive density is air
+	if (density.min > margin)
+		return VolumeClass::Air;
+	if (density.max >= -margin)
+		return VolumeClass::Mixed;
+
+	// under the surface, caves are the only thing left that can carve air out
+	const FastNoise::OutputMinMax cave = sampleBounds(Noise_Cave, frequencyScale * s_chunkGenParams->caveFrequency, margin);
+	return cave.max <= -margin ? VolumeClass::Solid : VolumeClass::Mixed;
+}
 
-	const int turbulentRowSize = INT_CHUNK_VOXEL_SIZE;
+bool Chunk::IsNoiseStepPruned(const ChunkNoiseGenerators* generators, NoiseOutput output) const
+{
+	int profileMaxLOD = INT_MAX;
+	switch (output)
+	{
+	case Noise_Dirt:
+		profileMaxLOD = s_chunkGenParams->dirtMaxLOD;
+		break;
+	case Noise_Biome:
+		profileMaxLOD = s_chunkGenParams->biomeMaxLOD;
+		break;
+	case Noise_Cave:
+		profileMaxLOD = s_chunkGenParams->caveMaxLOD;
+		break;
+	default:
+		break;
+	}
+	return int(m_LOD) > profileMaxLOD || generators->steps[output].IsPruned(m_LOD);
+}
+
+void Chunk::GenerateGridAdaptive(const ChunkNoiseGenerators::Step& step, const glm::ivec3& noiseStartPos, float frequencyScale, float error, float* grid) const
+{
+	ZoneScoped;
 	ScratchpadMemoryLayout& scratchMem = s_scratchpadMemory[s_threadIDs[std::this_thread::get_id()]];
+	constexpr int SIZE = INT_CHUNK_VOXEL_SIZE;
+	constexpr int STEP = 4;
+	// the last cell hangs off the end of the volume, the noise doesnt care
+	constexpr int CELLS = (SIZE - 1 + STEP - 1) / STEP;
+	constexpr int CORNERS = CELLS + 1;
+	constexpr int CORNER_COUNT = CORNERS * CORNERS * CORNERS;
+	static_assert(CORNER_COUNT <= SIZE * SIZE * SIZE);
+
+	int i = 0;
+	for (int z = 0; z < CORNERS; z++)
+	{
+		for (int y = 0; y < CORNERS; y++)
+		{
+			for (int x = 0; x < CORNERS; x++)
+			{
+				scratchMem.adaptiveSampleX[i] = float(noiseStartPos.x + x * STEP) * frequencyScale;
+				scratchMem.adaptiveSampleY[i] = float(noiseStartPos.y + y * STEP) * frequencyScale;
+				scratchMem.adaptiveSampleZ[i] = float(noiseStartPos.z + z * STEP) * frequencyScale;
+				i++;
+			}
+		}
+	}
+	float corners[CORNERS][CORNERS][CORNERS];
+	step.generator->GenPositionArray3D(
+		&corners[0][0][0],
+		CORNER_COUNT,
+		scratchMem.adaptiveSampleX,
+		scratchMem.adaptiveSampleY,
+		scratchMem.adaptiveSampleZ,
+		0, 0, 0,
+		step.seed
+	);
+
+	// corners[z][y][x] like the output grid
+	uint sampleCount = 0;
+	for (int cz = 0; cz < CELLS; cz++)
+	{
+		for (int cy = 0; cy < CELLS; cy++)
+		{
+			for (int cx = 0; cx < CELLS; cx++)
+			{
+				const float c000 = corners[cz][cy][cx];
+				const float c001 = corners[cz][cy][cx + 1];
+				const float c010 = corners[cz][cy + 1][cx];
+				const float c011 = corners[cz][cy + 1][cx + 1];
+				const float c100 = corners[cz + 1][cy][cx];
+				const float c101 = corners[cz + 1][cy][cx + 1];
+				const float c110 = corners[cz + 1][cy + 1][cx];
+				const float c111 = corners[cz + 1][cy + 1][cx + 1];
+				const float minCorner = std::min({ c000, c001, c010, c011, c100, c101, c110, c111 });
+				const float maxCorner = std::max({ c000, c001, c010, c011, c100, c101, c110, c111 });
+				const bool interpolate = minCorner > error || maxCorner < -error;
+
+				const int xEnd = std::min((cx + 1) * STEP, SIZE);
+				const int yEnd = std::min((cy + 1) * STEP, SIZE);
+				const int zEnd = std::min((cz + 1) * STEP, SIZE);
+				for (int z = cz * STEP; z < zEnd; z++)
+				{
+					const float tz = float(z - cz * STEP) / STEP;
+					for (int y = cy * STEP; y < yEnd; y++)
+					{
+						const float ty = float(y - cy * STEP) / STEP;
+						for (int x = cx * STEP; x < xEnd; x++)
+						{
+							const int index = x + SIZE * y + SIZE * SIZE * z;
+							if (interpolate)
+							{
+								const float tx = float(x - cx * STEP) / STEP;
+								const float c00 = c000 + (c001 - c000) * tx;
+								const float c01 = c010 + (c011 - c010) * tx;
+								const float c10 = c100 + (c101 - c100) * tx;
+								const float c11 = c110 + (c111 - c110) * tx;
+								const float c0 = c00 + (c01 - c00) * ty;
+								const float c1 = c10 + (c11 - c10) * ty;
+								grid[index] = c0 + (c1 - c0) * tz;
+							}
+							else
+							{
+								// near the surface, sample it exactly so the voxel comes out the same as the full grid
+								scratchMem.adaptiveSampleX[sampleCount] = float(noiseStartPos.x + x) * frequencyScale;
+								scratchMem.adaptiveSampleY[sampleCount] = float(noiseStartPos.y + y) * frequencyScale;
+								scratchMem.adaptiveSampleZ[sampleCount] = float(noiseStartPos.z + z) * frequencyScale;
+								scratchMem.adaptiveSampleVoxels[sampleCount] = uint16_t(index);
+								sampleCount++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
 
-	glm::ivec3 noiseStartPos;
-	float frequencyScale;
-	GetNoiseGenPos(m_chunkPos, glm::vec3(0), m_LOD, noiseStartPos, frequencyScale);
-	frequencyScale *= FREQUENCY;
-	if (!s_chunkGenParams->m_debugFlatWorld)
+	if (sampleCount)
 	{
-		// samples once per int, so we pass in bigger positions than our actual worldspace position...
-		generators->noiseGenerator->GenUniformGrid2D(
-			scratchMem.noise2D1,
-			noiseStartPos.x,
-			noiseStartPos.z,
-			turbulentRowSize,
-			turbulentRowSize,
-			frequencyScale * s_chunkGenParams->terrainFrequency,
-			1
-		);
-		// this is kinda overkill for just the dirt
-		generators->noiseGenerator->GenUniformGrid2D(
-			scratchMem.noise2D2,
-			noiseStartPos.x,
-			noiseStartPos.z,
-			INT_CHUNK_VOXEL_SIZE,
-			INT_CHUNK_VOXEL_SIZE,
-			frequencyScale * 20,
-			1337
-		);
-		generators->biomeGenerator->GenUniformGrid2D(
-			scratchMem.noise2D3,
-			noiseStartPos.x,
-			noiseStartPos.z,
-			INT_CHUNK_VOXEL_SIZE,
-			INT_CHUNK_VOXEL_SIZE,
-			frequencyScale,
-			1337
+		step.generator->GenPositionArray3D(
+			scratchMem.adaptiveSamples,
+			int(sampleCount),
+			scratchMem.adaptiveSampleX,
+			scratchMem.adaptiveSampleY,
+			scratchMem.adaptiveSampleZ,
+			0, 0, 0,
+			step.seed
 		);
-		generators->noiseGenerator->GenUniformGrid3D(
-			scratchMem.noise3D1,
+		for (uint j = 0; j < sampleCount; j++)
+			grid[scratchMem.adaptiveSampleVoxels[j]] = scratchMem.adaptiveSamples[j];
+	}
+}
+
+bool Chunk::IsNoiseGridAdaptive(NoiseOutput output) const
+{
+	return (output == Noise_Density && s_chunkGenParams->adaptiveDensity) ||
+		(output == Noise_Cave && int(m_LOD) > s_chunkGenParams->caveCoarseLOD);
+}
+
+void Chunk::GenerateNoiseGrid(const ChunkNoiseGenerators* generators, NoiseOutput output, const glm::ivec3& noiseStartPos, float frequencyScale, float* grid, int zBegin, int zEnd) const
+{
+	ZoneScoped;
+	const ChunkNoiseGenerators::Step& step = generators->steps[output];
+	const bool is3D = output == Noise_Density || output == Noise_Cave;
+	constexpr int LAYER_SIZE = INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE;
+	if (IsNoiseStepPruned(generators, output))
+	{
+		if (is3D)
+			std::fill(grid + zBegin * LAYER_SIZE, grid + zEnd * LAYER_SIZE, step.fill);
+		else
+			std::fill(grid, grid + LAYER_SIZE, step.fill);
+		return;
+	}
+
+	float frequency = frequencyScale * step.frequency;
+	if (output == Noise_Height)
+		frequency *= s_chunkGenParams->terrainFrequency;
+	else if (output == Noise_Cave)
+		frequency *= s_chunkGenParams->caveFrequency;
+
+	if (IsNoiseGridAdaptive(output))
+	{
+		// adaptive grids dont split into slabs
+		assert(zBegin == 0 && zEnd == INT_CHUNK_VOXEL_SIZE);
+		// a cave a few voxels wide is about as much as shows up when caves are coarse
+		const float error = output == Noise_Density ? s_chunkGenParams->adaptiveDensityError : -std::numeric_limits<float>::infinity();
+		GenerateGridAdaptive(step, noiseStartPos, frequency, error, grid);
+	}
+	else if (is3D)
+	{
+		step.generator->GenUniformGrid3D(
+			grid + zBegin * LAYER_SIZE,
 			noiseStartPos.x,
 			noiseStartPos.y,
-			noiseStartPos.z,
-			INT_CHUNK_VOXEL_SIZE,
+			noiseStartPos.z + zBegin,
 			INT_CHUNK_VOXEL_SIZE,
 			INT_CHUNK_VOXEL_SIZE,
-			frequencyScale,
-			1337
+			zEnd - zBegin,
+			frequency,
+			step.seed
 		);
-		generators->noiseGeneratorCave->GenUniformGrid3D(
-			scratchMem.noise3D2,
+	}
+	else
+	{
+		// samples once per int, so we pass in bigger positions than our actual worldspace position...
+		step.generator->GenUniformGrid2D(
+			grid,
 			noiseStartPos.x,
-			noiseStartPos.y,
 			noiseStartPos.z,
 			INT_CHUNK_VOXEL_SIZE,
 			INT_CHUNK_VOXEL_SIZE,
-			INT_CHUNK_VOXEL_SIZE,
-			frequencyScale * s_chunkGenParams->caveFrequency,
-			1337
+			frequency,
+			step.seed
 		);
 	}
+}
+
+bool Chunk::GenerateVolumeFromNoise(const ChunkNoiseGenerators* generators)
+{
+	constexpr float FREQUENCY = 1 / 200.f;
+
+	ScratchpadMemoryLayout& scratchMem = s_scratchpadMemory[s_threadIDs[std::this_thread::get_id()]];
+
+	glm::ivec3 noiseStartPos;
+	float frequencyScale;
+	GetNoiseGenPos(m_chunkPos, glm::vec3(0), m_LOD, noiseStartPos, frequencyScale);
+	frequencyScale *= FREQUENCY;
+	const int slabs = GetGenerationSlabs();
+	if (!s_chunkGenParams->m_debugFlatWorld && s_chunkGenParams->classifyVolumes)
+	{
+		// most of the octree is sky or deep underground
+		const VolumeClass volumeClass = ClassifyVolume(generators, noiseStartPos, frequencyScale);
+		if (volumeClass == VolumeClass::Air)
+			return true;
+		// skirts sample the density at their own positions, outside anything the classification looked at. so only lod 0,
+		// which has no skirts, can trust a solid result
+		if (volumeClass == VolumeClass::Solid && m_LOD == 0)
+		{
+			// every voxel has solid above it, which makes it subsurface
+			std::fill(&m_voxelData->m_voxels[0][0][0], &m_voxelData->m_voxels[0][0][0] + INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE, generators->subsurfaceBlock);
+			return false;
+		}
+	}
+	if (!s_chunkGenParams->m_debugFlatWorld)
+	{
+		// every grid only depends on the plan, so they can be filled in any order on any thread and come out the same
+		float* const grids[Num_NoiseOutputs] = { scratchMem.noise2D1, scratchMem.noise2D2, scratchMem.noise2D3, scratchMem.noise3D1, scratchMem.noise3D2 };
+		const bool cacheColumnNoise = RenderSettings::Get().cacheColumnNoise;
+		const glm::ivec3 columnKey(noiseStartPos.x, noiseStartPos.z, m_LOD);
+		const bool columnCached = cacheColumnNoise && s_noiseColumnCache.Get(columnKey, scratchMem.noise2D1, scratchMem.noise2D2, scratchMem.noise2D3);
+
+		// 3d grids split into z slabs when the chunk does, each slab is a contiguous run of the grid
+		struct NoiseTask
+		{
+			NoiseOutput output;
+			int zBegin;
+			int zEnd;
+		};
+		NoiseTask tasks[Num_NoiseOutputs * INT_CHUNK_VOXEL_SIZE];
+		uint taskCount = 0;
+		for (uint output = columnCached ? uint(Noise_Density) : 0u; output < Num_NoiseOutputs; output++)
+		{
+			const bool is3D = output == Noise_Density || output == Noise_Cave;
+			const int gridSlabs = (is3D && !IsNoiseGridAdaptive(NoiseOutput(output))) ? slabs : 1;
+			for (int slab = 0; slab < gridSlabs; slab++)
+				tasks[taskCount++] = { NoiseOutput(output), GetSlabBegin(slab, gridSlabs), GetSlabBegin(slab + 1, gridSlabs) };
+		}
+		auto generateGrid = [&](uint i)
+		{
+			const NoiseTask& task = tasks[i];
+			GenerateNoiseGrid(generators, task.output, noiseStartPos, frequencyScale, grids[task.output], task.zBegin, task.zEnd);
+		};
+		if (s_parallelFor && (RenderSettings::Get().parallelNoiseGrids || slabs > 1))
+		{
+			s_parallelFor(taskCount, generateGrid);
+		}
+		else
+		{
+			for (uint i = 0; i < taskCount; i++)
+				generateGrid(i);
+		}
+
+		if (cacheColumnNoise && !columnCached)
+			s_noiseColumnCache.Put(columnKey, scratchMem.noise2D1, scratchMem.noise2D2, scratchMem.noise2D3);
+	}
+
+	// slabs only write their own voxels, opaque rows and part of the skirt lists
+	bool emptyVal;
+	if (slabs > 1)
+	{
+		bool slabEmpty[INT_CHUNK_VOXEL_SIZE];
+		s_parallelFor(slabs, [&](uint slab)
+		{
+			slabEmpty[slab] = GenerateVolumeSlab(generators, scratchMem, GetSlabBegin(slab, slabs), GetSlabBegin(slab + 1, slabs));
+		});
+		emptyVal = std::all_of(slabEmpty, slabEmpty + slabs, [](bool empty) { return empty; });
+	}
+	else
+	{
+		emptyVal = GenerateVolumeSlab(generators, scratchMem, 0, INT_CHUNK_VOXEL_SIZE);
+	}
+	scratchMem.opaqueRowsChunk = this;
+	return emptyVal;
+}
+
+int Chunk::GetGenerationSlabs() const
+{
+	// only worth the sub-job overhead for the chunks right around the player
+	if (!s_parallelFor || m_LOD != 0)
+		return 1;
+	return std::clamp(RenderSettings::Get().generationSlabs, 1, INT_CHUNK_VOXEL_SIZE);
+}
+
+int Chunk::GetSlabBegin(int slab, int slabs)
+{
+	return slab * INT_CHUNK_VOXEL_SIZE / slabs;
+}
+
+uint Chunk::GetSkirtSlabOffset(int zBegin)
+{
+	// the z faces have a whole layer of skirt voxels, every other layer only has its 4 edges
+	constexpr uint FACE_VOXELS = CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE;
+	constexpr uint EDGE_VOXELS = 4 * CHUNK_VOXEL_SIZE;
+	static_assert(2 * FACE_VOXELS + CHUNK_VOXEL_SIZE * EDGE_VOXELS == ScratchpadMemoryLayout::MAX_SKIRT_VOXELS);
+	return zBegin == 0 ? 0 : FACE_VOXELS + (zBegin - 1) * EDGE_VOXELS;
+}
+
+bool Chunk::GenerateVolumeSlab(const ChunkNoiseGenerators* generators, ScratchpadMemoryLayout& scratchMem, int zBegin, int zEnd)
+{
+	const float TERRAIN_HEIGHT = s_chunkGenParams->terrainHeight;
+	constexpr float DIRT_HEIGHT = 2.0f;
 
 	bool emptyVal = true;
 	bool fullVal = true;
 	bool isEdge = false;
+	const bool batchSkirts = RenderSettings::Get().batchSkirtNoise;
+	// skirts sample the finer lods density, which is never pruned where skirts are
+	const ChunkNoiseGenerators::Step& density = generators->steps[Noise_Density];
+	static_assert(INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE <= (1 << 16), "skirt voxels are indexed with a uint16_t");
+	const uint skirtOffset = GetSkirtSlabOffset(zBegin);
+	uint skirtVoxelCount = skirtOffset;
+	uint skirtSampleCount = skirtOffset * 4;
 	// would putting y on the inside be faster? what if y was the inner most index on the 3d array?. 
 	// going top down could also aid in grass gen if we put y on inside
-	for (int z = 0; z < INT_CHUNK_VOXEL_SIZE; z++)
+	for (int z = zBegin; z < zEnd; z++)
 	{
 		int zEdge = (z == 0) ? 1 : (z == INT_CHUNK_VOXEL_SIZE - 1) ? -1 : 0;
 		for (int y = 0; y < INT_CHUNK_VOXEL_SIZE; y++)
 		{
 			int yEdge = (y == 0) ? 1 : (y == INT_CHUNK_VOXEL_SIZE - 1) ? -1 : 0;
 			float worldSpaceHeight = (y - 1) * m_scale * VOXEL_UNIT_SIZE + m_chunkPos.y;
+			uint64_t opaqueRow = 0;
 			for (int x = 0; x < INT_CHUNK_VOXEL_SIZE; x++)
 			{
 				int xEdge = (x == 0) ? 1 : (x == INT_CHUNK_VOXEL_SIZE - 1) ? -1 : 0;
@@ -416,18 +1001,15 @@ void Chunk::GenerateVolume(const ChunkNoiseGenerators* generators)
 				}
 				BlockType blockType = BlockType::Air;
 				float biome = scratchMem.noise2D3[x + z * INT_CHUNK_VOXEL_SIZE];
-				BlockType biomeBlock = BlockType::Blue;
-				if (biome < -0.2f)
-				{
-					biomeBlock = BlockType::Blue;
-				}
-				else if (biome < 0.3f)
-				{
-					biomeBlock = BlockType::Grass;
-				}
-				else
+				// the last band catches everything above it
+				BlockType biomeBlock = generators->biomes.back().block;
+				for (const ChunkNoiseGenerators::BiomeBand& band : generators->biomes)
 				{
-					biomeBlock = BlockType::Sand;
+					if (biome < band.maxValue)
+					{
+						biomeBlock = band.block;
+						break;
+					}
 				}
 
 				worldSpaceHeight = scratchMem.noise3D1[x + INT_CHUNK_VOXEL_SIZE * y + INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * z];
@@ -456,7 +1038,7 @@ void Chunk::GenerateVolume(const ChunkNoiseGenerators* generators)
 						//else if (depth < dirtHeight + 1)
 						//	m_voxelData->m_voxels[x][y][z] = BlockType::Dirt;
 						else
-							blockType = BlockType::Stone;
+							blockType = generators->subsurfaceBlock;
 						emptyVal = false;
 					}
 				}
@@ -494,55 +1076,95 @@ void Chunk::GenerateVolume(const ChunkNoiseGenerators* generators)
 							lodPos.z = 2 * z;
 					}
 
+					const glm::vec3 skirtSamples[4] = { lodPos, lodPos + offset1, lodPos + offset2, lodPos + offset1 + offset2 };
 					glm::ivec3 newNoiseStartPos;
 					float frequencyScale;
-					GetNoiseGenPos(m_chunkPos, lodPos, m_LOD - 1, newNoiseStartPos, frequencyScale);
-					frequencyScale *= FREQUENCY;
-					if (generators->noiseGenerator->GenSingle3D(newNoiseStartPos.x, newNoiseStartPos.y, newNoiseStartPos.z, 1337) > 0.0f)
-					{
-						blockType = BlockType::Air;
-					}
-					GetNoiseGenPos(m_chunkPos, lodPos + offset1, m_LOD - 1, newNoiseStartPos, frequencyScale);
-					frequencyScale *= FREQUENCY;
-					if (generators->noiseGenerator->GenSingle3D(newNoiseStartPos.x, newNoiseStartPos.y, newNoiseStartPos.z, 1337) > 0.0f)
-					{
-						blockType = BlockType::Air;
-					}
-					GetNoiseGenPos(m_chunkPos, lodPos + offset2, m_LOD - 1, newNoiseStartPos, frequencyScale);
-					frequencyScale *= FREQUENCY;
-					if (generators->noiseGenerator->GenSingle3D(newNoiseStartPos.x, newNoiseStartPos.y, newNoiseStartPos.z, 1337) > 0.0f)
+					if (batchSkirts)
 					{
-						blockType = BlockType::Air;
+						// evaluated all at once after the loop
+						for (const glm::vec3& samplePos : skirtSamples)
+						{
+							GetNoiseGenPos(m_chunkPos, samplePos, m_LOD - 1, newNoiseStartPos, frequencyScale);
+							scratchMem.skirtSampleX[skirtSampleCount] = float(newNoiseStartPos.x) * density.frequency;
+							scratchMem.skirtSampleY[skirtSampleCount] = float(newNoiseStartPos.y) * density.frequency;
+							scratchMem.skirtSampleZ[skirtSampleCount] = float(newNoiseStartPos.z) * density.frequency;
+							skirtSampleCount++;
+						}
+						scratchMem.skirtVoxels[skirtVoxelCount++] = uint16_t(&m_voxelData->m_voxels[x][y][z] - &m_voxelData->m_voxels[0][0][0]);
 					}
-					GetNoiseGenPos(m_chunkPos, lodPos + offset1 + offset2, m_LOD - 1, newNoiseStartPos, frequencyScale);
-					frequencyScale *= FREQUENCY;
-					if (generators->noiseGenerator->GenSingle3D(newNoiseStartPos.x, newNoiseStartPos.y, newNoiseStartPos.z, 1337) > 0.0f)
+					else
 					{
-						blockType = BlockType::Air;
+						for (const glm::vec3& samplePos : skirtSamples)
+						{
+							GetNoiseGenPos(m_chunkPos, samplePos, m_LOD - 1, newNoiseStartPos, frequencyScale);
+							const glm::vec3 noisePos = glm::vec3(newNoiseStartPos) * density.frequency;
+							if (density.generator->GenSingle3D(noisePos.x, noisePos.y, noisePos.z, density.seed) > 0.0f)
+							{
+								blockType = BlockType::Air;
+							}
+						}
 					}
 				}
 				m_voxelData->m_voxels[x][y][z] = blockType;
+				opaqueRow |= uint64_t(BlockIsOpaque(blockType)) << x;
 			}
+			scratchMem.opaqueRows[z][y] = opaqueRow;
 		}
-	}	
+	}
 
-	m_generated.store(true);
-	m_empty = emptyVal;
-	// can do the same thing with full chunks.
-	if (emptyVal)
+	// one pass over every skirt sample instead of four scalar evaluations of the whole node tree per edge voxel
+	if (skirtVoxelCount > skirtOffset)
 	{
-		s_memPool.Free(m_voxelData);
-		m_voxelData = nullptr;
+		density.generator->GenPositionArray3D(
+			scratchMem.skirtNoise + skirtOffset * 4,
+			int(skirtSampleCount - skirtOffset * 4),
+			scratchMem.skirtSampleX + skirtOffset * 4,
+			scratchMem.skirtSampleY + skirtOffset * 4,
+			scratchMem.skirtSampleZ + skirtOffset * 4,
+			0, 0, 0,
+			density.seed
+		);
+		BlockType* voxels = &m_voxelData->m_voxels[0][0][0];
+		for (uint i = skirtOffset; i < skirtVoxelCount; i++)
+		{
+			const float* noise = &scratchMem.skirtNoise[i * 4];
+			if (noise[0] > 0.0f || noise[1] > 0.0f || noise[2] > 0.0f || noise[3] > 0.0f)
+			{
+				const uint voxel = scratchMem.skirtVoxels[i];
+				voxels[voxel] = BlockType::Air;
+				scratchMem.opaqueRows[voxel % INT_CHUNK_VOXEL_SIZE][(voxel / INT_CHUNK_VOXEL_SIZE) % INT_CHUNK_VOXEL_SIZE] &= ~(1ull << (voxel / (INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE)));
+			}
+		}
 	}
 
-	auto endTime = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double, std::milli> time = endTime - startTime;
-	m_genTime += time.count();
+	return emptyVal;
+}
+
+void Chunk::GenerateVolumeFromFunction(const std::function<BlockType(int, int, int)>& fn)
+{
+	if (m_voxelData == nullptr)
+		m_voxelData = s_memPool.New();
+
+	bool emptyVal = true;
+	for (int x = 0; x < INT_CHUNK_VOXEL_SIZE; x++)
+	{
+		for (int y = 0; y < INT_CHUNK_VOXEL_SIZE; y++)
+		{
+			for (int z = 0; z < INT_CHUNK_VOXEL_SIZE; z++)
+			{
+				BlockType blockType = fn(x - 1, y - 1, z - 1);
+				m_voxelData->m_voxels[x][y][z] = blockType;
+				emptyVal = emptyVal && blockType == BlockType::Air;
+			}
+		}
+	}
+	BuildCollisionRows();
 
-	GenerateMesh();
+	m_generated.store(true);
+	m_empty = emptyVal;
 }
 
-void Chunk::GenerateMesh()
+void Chunk::GenerateMesh(const OpaqueRows* opaqueRows)
 {
 	auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -561,27 +1183,31 @@ void Chunk::GenerateMesh()
 
 	m_state = ChunkState::GeneratingMesh;
 
-	m_vertexCount = 0;
-	m_indexCount = 0;
+	m_quadCount = 0;
 
-	m_vertices.clear();
+	ReleaseQuads();
 	m_meshGenerated = 0;
 	m_noGeo = 0;
 
 	lock.unlock();
 
+	m_faceConnectivity = ComputeFaceConnectivity();
+
 	//if (RenderSettings::Get().greedyMesh)
 	{
-		GenerateGreedyMeshInt();
+		GenerateGreedyMeshInt(opaqueRows);
 	}
 	//else
 	//{
 	//	GenerateMeshInt();
 	//}
 
+	assert(m_quadCount == m_quads.size() && m_quadCount <= MAX_QUADS);
+	assert(m_faceQuadOffsets[BlockFace::NumFaces] == m_quadCount);
+
 	lock.lock();
 	
-	if (m_vertexCount == 0)
+	if (m_quadCount == 0)
 	{
 		m_noGeo = 1;
 		m_state = ChunkState::Done;
@@ -592,6 +1218,9 @@ void Chunk::GenerateMesh()
 	}
 
 	m_meshGenerated = 1;
+	// before anyone can see the new state, so a swap from an edit cant get clobbered
+	m_buffersGenerated = false;
+	m_meshCompleteTime = std::chrono::high_resolution_clock::now();
 
 	m_renderable = (!IsEmpty() && !IsNoGeo() && (m_state == ChunkState::Done || m_state == ChunkState::GeneratingBuffers));
 
@@ -600,8 +1229,6 @@ void Chunk::GenerateMesh()
 	if (m_renderable)
 		s_renderListCallback(this);
 
-	m_buffersGenerated = false;
-
 	auto endTime = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double, std::milli> time = endTime - startTime;
 	m_genTime += time.count();
@@ -626,25 +1253,71 @@ void Chunk::SetTerrainParams(float lacunarity, float gain, int octaves)
 
 bool Chunk::IsInFrustum(const Frustum& f) const
 {
-	return m_AABB.IsInFrustumWorldspace(f);
+	return GetBoundingBox().IsInFrustumWorldspace(f);
+}
+
+// positions run 0..CHUNK_VOXEL_SIZE inclusive and extents 1..CHUNK_VOXEL_SIZE
+static_assert(CHUNK_VOXEL_SIZE < 64, "quad positions are packed into 6 bits");
+static_assert(CHUNK_VOXEL_SIZE <= 32, "quad extents are packed into 5 bits");
+// quads are found with gl_VertexID / 6 and a whole mesh has to fit in one storage buffer
+static_assert(uint64_t(Chunk::MAX_QUADS) * 6 <= INT32_MAX, "chunk mesh overflows gl_VertexID");
+static_assert(uint64_t(Chunk::MAX_QUADS) * sizeof(Chunk::PackedQuad) <= (1u << 27), "GL only guarantees 128MB shader storage blocks");
+
+// quad origin is the corner with the smallest coords, w/h run along u = (axis + 1) % 3 and v = (axis + 2) % 3
+static Chunk::PackedQuad PackQuad(const glm::uvec3& pos, uint w, uint h, BlockFace face, Chunk::BlockType blockType, uint ao)
+{
+	assert(pos.x <= CHUNK_VOXEL_SIZE && pos.y <= CHUNK_VOXEL_SIZE && pos.z <= CHUNK_VOXEL_SIZE);
+	assert(w >= 1 && w <= CHUNK_VOXEL_SIZE && h >= 1 && h <= CHUNK_VOXEL_SIZE);
+	Chunk::PackedQuad quad;
+	quad.position = (0x3F & pos.x) | (0x3F & pos.y) << 6 | (0x3F & pos.z) << 12 | (0x1F & (w - 1)) << 18 | (0x1F & (h - 1)) << 23 | (0x7 & face) << 28;
+	quad.attributes = uint8_t(blockType) | (0xFF & ao) << 8;
+	return quad;
+}
+
+// all corners fully lit
+constexpr uint NO_AO = 0xFF;
+
+// per corner occlusion of a face, looking at the voxels around airVoxel (the one the face looks into) in its u/v plane.
+// https://0fps.net/2013/07/03/ambient-occlusion-for-minecraft-like-worlds/
+uint Chunk::ComputeFaceAO(const glm::i32vec3& airVoxel, int u, int v) const
+{
+	auto opaque = [this](const glm::i32vec3& p) { return BlockIsOpaque(m_voxelData->m_voxels[p.x + 1][p.y + 1][p.z + 1]); };
+
+	uint ao = 0;
+	for (uint corner = 0; corner < 4; corner++)
+	{
+		glm::i32vec3 du(0), dv(0);
+		du[u] = (corner & 1) ? 1 : -1;
+		dv[v] = (corner & 2) ? 1 : -1;
+		const uint side1 = opaque(airVoxel + du);
+		const uint side2 = opaque(airVoxel + dv);
+		const uint cornerVoxel = opaque(airVoxel + du + dv);
+		const uint cornerAO = (side1 && side2) ? 0 : 3 - (side1 + side2 + cornerVoxel);
+		ao |= cornerAO << (corner * 2);
+	}
+	return ao;
 }
 
 void Chunk::GenerateMeshInt()
 {
 	assert(CHUNK_VOXEL_SIZE < 64);
 	std::lock_guard lock(m_mutex);
-	for (uint x = 0; x < CHUNK_VOXEL_SIZE; x++)
+	std::vector<PackedQuad>& quads = s_scratchpadMemory[s_threadIDs[std::this_thread::get_id()]].meshStaging[0][0];
+	quads.clear();
+	// faces outermost so each direction ends up in its own contiguous range
+	for (uint i = 0; i < BlockFace::NumFaces; i++)
 	{
-		for (uint y = 0; y < CHUNK_VOXEL_SIZE; y++)
+		m_faceQuadOffsets[i] = m_quadCount;
+		for (uint x = 0; x < CHUNK_VOXEL_SIZE; x++)
 		{
-			for (uint z = 0; z < CHUNK_VOXEL_SIZE; z++)
+			for (uint y = 0; y < CHUNK_VOXEL_SIZE; y++)
 			{
-				BlockType currentBlockType = m_voxelData->m_voxels[x + 1][y + 1][z + 1];
-				if (BlockIsOpaque(currentBlockType))
+				for (uint z = 0; z < CHUNK_VOXEL_SIZE; z++)
 				{
-					glm::vec3 offset{ x,y,z };
-					for (uint i = 0; i < BlockFace::NumFaces; i++)
+					BlockType currentBlockType = m_voxelData->m_voxels[x + 1][y + 1][z + 1];
+					if (BlockIsOpaque(currentBlockType))
 					{
+						glm::vec3 offset{ x,y,z };
 						const glm::vec normal = s_blockNormals[i];
 						int neighborX = x + normal.x + 1;
 						int neighborY = y + normal.y + 1;
@@ -655,173 +1328,549 @@ void Chunk::GenerateMeshInt()
 
 						if (m_needsLODSeam)
 							currentBlockType = BlockType::Dirt;
-						// add faces
-						for (uint j = 0; j < 4; j++)
-						{
-							// vertex packing idea from https://www.youtube.com/watch?v=VQuN1RMEr1c
-							glm::uvec3 localVertexPos = (s_faces[i][j] + offset);
-							uint packedVertex = (0x3F & localVertexPos.x) | (0xFC0 & (localVertexPos.y << 6)) | (0x3F000 & (localVertexPos.z << 12)) | (0x1C0000 & (i << 18)) | (0x1FE00000 & (uint8_t(currentBlockType) << 21));
-							m_vertices.push_back(packedVertex);
-						}
-						m_indexCount += 6;
-						m_vertexCount += 4;
-						//m_indices.insert(m_indices.end(), std::begin(indices), std::end(indices));
+						uint ao = NO_AO;
+						if (s_chunkGenParams->ambientOcclusion)
+							ao = ComputeFaceAO(glm::i32vec3(offset + normal), (i / 2 + 1) % 3, (i / 2 + 2) % 3);
+						// positive faces sit on the far side of the voxel
+						glm::uvec3 quadPos = offset + (i % 2 == 0 ? normal : glm::vec3(0));
+						quads.push_back(PackQuad(quadPos, 1, 1, BlockFace(i), currentBlockType, ao));
+						m_quadCount++;
 					}
 				}
 			}
 		}
 	}
+	m_faceQuadOffsets[BlockFace::NumFaces] = m_quadCount;
+	AllocateQuads(quads.size());
+	m_quads.insert(m_quads.end(), quads.begin(), quads.end());
 }
 
 // https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
-void Chunk::GenerateGreedyMeshInt()
+void Chunk::GenerateGreedyMeshInt(const OpaqueRows* opaqueRows)
+{
+	// each axis sweeps into this threads staging lists, then theyre spliced in the same order GreedyMesh makes.
+	// the lists keep their capacity so m_quads is the only allocation, at its final size
+	std::vector<PackedQuad> (&staging)[3][2] = s_scratchpadMemory[s_threadIDs[std::this_thread::get_id()]].meshStaging;
+	// planes without an opacity change cant make quads, so their masks never get built
+	uint64_t facePlanes[3] = { ~0ull, ~0ull, ~0ull };
+	if (opaqueRows)
+		GetFacePlanes(*opaqueRows, facePlanes);
+	auto sweepAxis = [&](uint dim)
+	{
+		staging[dim][0].clear();
+		staging[dim][1].clear();
+		for (int plane = 0; plane <= CHUNK_VOXEL_SIZE; plane++)
+		{
+			if ((facePlanes[dim] >> plane) & 1)
+				GreedySweepPlane(int(dim), plane, staging[dim][0], staging[dim][1]);
+		}
+	};
+	if (s_parallelFor && m_LOD == 0 && RenderSettings::Get().splitMeshSweeps)
+	{
+		s_parallelFor(3, sweepAxis);
+	}
+	else
+	{
+		for (uint dim = 0; dim < 3; dim++)
+			sweepAxis(dim);
+	}
+	SpliceAxisQuads(staging);
+	m_quadCount = uint(m_quads.size());
+}
+
+void Chunk::AllocateQuads(size_t quadCount)
+{
+	ReleaseQuads();
+	m_quads.reserve(quadCount);
+	s_residentQuadBytes += m_quads.capacity() * sizeof(PackedQuad);
+}
+
+void Chunk::ReleaseQuads()
+{
+	s_residentQuadBytes -= m_quads.capacity() * sizeof(PackedQuad);
+	// clear keeps the capacity around, swapping is the only way to be sure its gone
+	std::vector<PackedQuad>().swap(m_quads);
+}
+
+size_t Chunk::GetResidentQuadBytes()
+{
+	return s_residentQuadBytes;
+}
+
+uint64_t Chunk::GetBufferCreations()
 {
+	return s_bufferCreations;
+}
+
+void Chunk::GetFacePlanes(const OpaqueRows& opaqueRows, uint64_t facePlanes[3])
+{
+	// plane k along an axis sits between voxel indices k and k + 1, only the interior u/v of it gets meshed
+	constexpr uint64_t INTERIOR_BITS = ((1ull << CHUNK_VOXEL_SIZE) - 1) << 1;
+	uint64_t xPlanes = 0;
+	uint64_t yPlanes = 0;
+	uint64_t zPlanes = 0;
+	for (int z = 0; z < INT_CHUNK_VOXEL_SIZE; z++)
+	{
+		const bool zInterior = z >= 1 && z <= CHUNK_VOXEL_SIZE;
+		for (int y = 0; y < INT_CHUNK_VOXEL_SIZE; y++)
+		{
+			const uint64_t row = opaqueRows[z][y];
+			const bool yInterior = y >= 1 && y <= CHUNK_VOXEL_SIZE;
+			if (zInterior && yInterior)
+				xPlanes |= row ^ (row >> 1);
+			if (zInterior && y <= CHUNK_VOXEL_SIZE && ((row ^ opaqueRows[z][y + 1]) & INTERIOR_BITS))
+				yPlanes |= 1ull << y;
+			if (yInterior && z <= CHUNK_VOXEL_SIZE && ((row ^ opaqueRows[z + 1][y]) & INTERIOR_BITS))
+				zPlanes |= 1ull << z;
+		}
+	}
+	constexpr uint64_t PLANE_BITS = (1ull << (CHUNK_VOXEL_SIZE + 1)) - 1;
+	facePlanes[0] = xPlanes & PLANE_BITS;
+	facePlanes[1] = yPlanes;
+	facePlanes[2] = zPlanes;
+}
+
+void Chunk::SpliceAxisQuads(const std::vector<PackedQuad> (&axisQuads)[3][2])
+{
+	size_t quadCount = 0;
+	for (uint dim = 0; dim < 3; dim++)
+		quadCount += axisQuads[dim][0].size() + axisQuads[dim][1].size();
+
+	AllocateQuads(quadCount);
+	for (uint dim = 0; dim < 3; dim++)
+	{
+		for (uint dir = 0; dir < 2; dir++)
+		{
+			m_faceQuadOffsets[dim * 2 + dir] = uint(m_quads.size());
+			m_quads.insert(m_quads.end(), axisQuads[dim][dir].begin(), axisQuads[dim][dir].end());
+		}
+	}
+	m_faceQuadOffsets[BlockFace::NumFaces] = uint(m_quads.size());
+}
+
+// planeOffsets is optional, see EditableMesh
+void Chunk::GreedyMesh(std::vector<PackedQuad>& quads, uint faceOffsets[BlockFace::NumFaces + 1], uint (*planeOffsets)[CHUNK_VOXEL_SIZE + 2]) const
+{
+	// back facing quads get held here until the sweep is done so each BlockFace ends up contiguous
+	std::vector<PackedQuad> backFaceQuads;
+
 	// sweep over each axis, generate forward and backward facing planes in one iteration
 	for (int dim = 0; dim < 3; dim++)
 	{
-		// u,v indices of other two dimensions that were not sweeping
-		int u = (dim + 1) % 3;
-		int v = (dim + 2) % 3;
+		backFaceQuads.clear();
+		faceOffsets[dim * 2] = uint(quads.size());
+
+		for (int plane = 0; plane <= CHUNK_VOXEL_SIZE; plane++)
+		{
+			if (planeOffsets)
+			{
+				planeOffsets[dim * 2][plane] = uint(quads.size());
+				planeOffsets[dim * 2 + 1][plane] = uint(backFaceQuads.size());
+			}
+			GreedySweepPlane(dim, plane, quads, backFaceQuads);
+		}
+
+		faceOffsets[dim * 2 + 1] = uint(quads.size());
+		if (planeOffsets)
+		{
+			planeOffsets[dim * 2][CHUNK_VOXEL_SIZE + 1] = uint(quads.size());
+			for (int plane = 0; plane <= CHUNK_VOXEL_SIZE; plane++)
+				planeOffsets[dim * 2 + 1][plane] += faceOffsets[dim * 2 + 1];
+			planeOffsets[dim * 2 + 1][CHUNK_VOXEL_SIZE + 1] = uint(quads.size() + backFaceQuads.size());
+		}
+		quads.insert(quads.end(), backFaceQuads.begin(), backFaceQuads.end());
+	}
+	faceOffsets[BlockFace::NumFaces] = uint(quads.size());
+}
 
-		// x is scratch pad for position of the block were currently processing.
-		glm::i32vec3 x(0, 0, 0);
-		glm::i32vec3 sweepDir(0, 0, 0);
-		sweepDir[dim] = 1;
+// builds the mask for the plane between voxel layers plane - 1 and plane along dim and merges it into as few quads as possible.
+// quads come out in a fixed order so a plane swept on its own matches what the full sweep made
+void Chunk::GreedySweepPlane(int dim, int plane, std::vector<PackedQuad>& frontQuads, std::vector<PackedQuad>& backQuads) const
+{
+	// u,v indices of other two dimensions that were not sweeping
+	int u = (dim + 1) % 3;
+	int v = (dim + 2) % 3;
+
+	// x is scratch pad for position of the block were currently processing.
+	glm::i32vec3 x(0, 0, 0);
+	glm::i32vec3 sweepDir(0, 0, 0);
+	sweepDir[dim] = 1;
+
+	// mask contains values of current slices neighboring voxel information.
+	// blockType * 2 + dir in the low 9 bits, face ao above that so quads only merge when their corners shade the same
+	uint32_t mask[CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE];
+	const bool ambientOcclusion = s_chunkGenParams->ambientOcclusion;
+
+	x[dim] = plane - 1;
+	// setup mask
+	for (x[v] = 0; x[v] < CHUNK_VOXEL_SIZE; x[v]++)
+	{
+		for (x[u] = 0; x[u] < CHUNK_VOXEL_SIZE; x[u]++)
+		{
+			// find block type of current block and the neighbor block in the direction were searching
+			BlockType t1 = m_voxelData->m_voxels[x[0] + 1][x[1] + 1][x[2] + 1];
+			BlockType t2 = m_voxelData->m_voxels[x[0] + sweepDir[0] + 1][x[1] + sweepDir[1] + 1][x[2] + sweepDir[2] + 1];
+
+			bool o1 = BlockIsOpaque(t1);
+			bool o2 = BlockIsOpaque(t2);
+
+			// write 0 if both opaque, 1 if we want face pointing in pos dir, 2 if neg
+			uint32_t maskVal = (o1 == o2) ? 0 : ((o1 && !o2) ? uint32_t(t1) * 2 : uint32_t(t2) * 2 + 1);
+			if (maskVal && ambientOcclusion)
+				maskVal |= ComputeFaceAO(o1 ? x + sweepDir : x, u, v) << 9;
+			mask[x[v]][x[u]] = maskVal;
+		}
+	}
 
-		// mask contains values of current slices neighboring voxel information
-		uint16_t mask[CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE] = { 0 };
+	x[dim]++;
 
-		// sweep over current dimension
-		for (x[dim] = -1; x[dim] < int(CHUNK_VOXEL_SIZE); )
+	// evaluate mask and generate faces as large as possible
+	for (int i = 0; i < CHUNK_VOXEL_SIZE; i++)
+	{
+		for (int j = 0; j < CHUNK_VOXEL_SIZE; )
 		{
-			int n = 0;
-			// setup mask
-			for (x[v] = 0; x[v] < CHUNK_VOXEL_SIZE; x[v]++)
+			if (uint32_t maskVal = mask[i][j])
 			{
-				for (x[u] = 0; x[u] < CHUNK_VOXEL_SIZE; x[u]++)
+				// find largest rect of same maskVal
+				int w = 1, h = 1;
+				while (j + w < CHUNK_VOXEL_SIZE && mask[i][j + w] == maskVal)
+				{
+					w++;
+				}
+				bool done = false;
+				while (i + h < CHUNK_VOXEL_SIZE && !done)
 				{
-					// find block type of current block and the neighbor block in the direction were searching
-					BlockType t1 = m_voxelData->m_voxels[x[0] + 1][x[1] + 1][x[2] + 1];
-					BlockType t2 = m_voxelData->m_voxels[x[0] + sweepDir[0] + 1][x[1] + sweepDir[1] + 1][x[2] + sweepDir[2] + 1];
+					for (int k = 0; k < w; k++)
+					{
+						if (mask[i + h][j + k] != maskVal)
+						{
+							done = true;
+							break;
+						}
+					}
+					if (done)
+						break;
+					h++;
+				}
 
-					bool o1 = BlockIsOpaque(t1);
-					bool o2 = BlockIsOpaque(t2);
+				// generate face from found rect
+				x[u] = j;
+				x[v] = i;
 
-					// write 0 if both opaque, 1 if we want face pointing in pos dir, 2 if neg
-					mask[x[v]][x[u]] = (o1 == o2) ? 0 : ((o1 && !o2) ? uint16_t(t1) * 2 : uint16_t(t2) * 2 + 1);
+				int normalDir = maskVal % 2 == 1 ? 1 : 0;
+				BlockFace b = BlockFace(dim * 2 + (normalDir));
+				BlockType blockType = BlockType((maskVal & 0x1FF) / 2);
+				uint ao = ambientOcclusion ? maskVal >> 9 : NO_AO;
+				std::vector<PackedQuad>& faceQuads = normalDir == 0 ? frontQuads : backQuads;
+				faceQuads.push_back(PackQuad(x, w, h, b, blockType, ao));
+
+				//Zero-out mask
+				for (int l = 0; l < h; ++l)
+				{
+					for (int k = 0; k < w; ++k)
+					{
+						mask[i + l][j + k] = 0;
+					}
 				}
+				//Increment counters and continue
+				j += w;
 			}
+			else
+			{
+				j++;  
+			}
+		}
+	}
+}
+
+// replaces the quads of one face/plane with quads and shifts everything after it
+void Chunk::SplicePlaneQuads(uint face, int plane, const std::vector<PackedQuad>& quads)
+{
+	EditableMesh& mesh = *m_editableMesh;
+	std::vector<PackedQuad>& meshQuads = mesh.quads;
+	const uint begin = mesh.planeQuadOffsets[face][plane];
+	const uint end = mesh.planeQuadOffsets[face][plane + 1];
+	const int delta = int(quads.size()) - int(end - begin);
+	if (delta == 0 && quads.empty())
+		return;
+
+	if (delta > 0)
+		meshQuads.insert(meshQuads.begin() + end, delta, PackedQuad());
+	else if (delta < 0)
+		meshQuads.erase(meshQuads.begin() + end + delta, meshQuads.begin() + end);
+	std::copy(quads.begin(), quads.end(), meshQuads.begin() + begin);
+
+	// same size just rewrites the range, otherwise everything after it moved
+	const uint dirtyEnd = delta == 0 ? end : uint(meshQuads.size());
+	if (mesh.dirtyEnd > mesh.dirtyBegin)
+	{
+		mesh.dirtyBegin = std::min(mesh.dirtyBegin, begin);
+		mesh.dirtyEnd = std::max(mesh.dirtyEnd, dirtyEnd);
+	}
+	else
+	{
+		mesh.dirtyBegin = begin;
+		mesh.dirtyEnd = dirtyEnd;
+	}
+
+	if (delta == 0)
+		return;
+	for (int k = plane + 1; k < CHUNK_VOXEL_SIZE + 2; k++)
+		mesh.planeQuadOffsets[face][k] += delta;
+	for (uint f = face + 1; f < BlockFace::NumFaces; f++)
+	{
+		for (int k = 0; k < CHUNK_VOXEL_SIZE + 2; k++)
+			mesh.planeQuadOffsets[f][k] += delta;
+	}
+}
+
+void Chunk::WriteVoxelRow(const glm::i32vec3& start, int length, BlockType type)
+{
+	assert(start.z >= -1 && start.z + length <= CHUNK_VOXEL_SIZE + 1);
+	if (m_voxelData == nullptr)
+	{
+		if (type == BlockType::Air)
+			return;
+		CreateEditVolume();
+	}
+	BlockType* row = &m_voxelData->m_voxels[start.x + 1][start.y + 1][start.z + 1];
+	std::fill(row, row + length, type);
+	UpdateCollisionRow(start.x, start.y, start.z, start.z + length - 1, type);
+	m_voxelRowsWritten = true;
+}
 
-			x[dim]++;
+void Chunk::CreateEditVolume()
+{
+	// pooled memory comes back dirty. CanApplyEdits keeps lod parents from reading us while this happens
+	VoxelData* voxelData = s_memPool.New();
+	*voxelData = VoxelData();
+	m_voxelData = voxelData;
+	m_empty = 0;
+}
 
-			// evaluate mask and generate faces as large as possible
-			for (int i = 0; i < CHUNK_VOXEL_SIZE; i++)
+void Chunk::CopyBorderFromNeighbors(const Chunk* neighbors[3][3][3])
+{
+	if (m_voxelData == nullptr)
+		CreateEditVolume();
+	// per offset along an axis: where the layer starts in our bordered volume, where it starts in the neighbors, and how many voxels
+	const int ourStart[3] = { 0, 1, CHUNK_VOXEL_SIZE + 1 };
+	const int theirStart[3] = { CHUNK_VOXEL_SIZE, 1, 1 };
+	const int count[3] = { 1, CHUNK_VOXEL_SIZE, 1 };
+	for (int ox = 0; ox < 3; ox++)
+	{
+		for (int oy = 0; oy < 3; oy++)
+		{
+			for (int oz = 0; oz < 3; oz++)
 			{
-				for (int j = 0; j < CHUNK_VOXEL_SIZE; )
+				const Chunk* neighbor = neighbors[ox][oy][oz];
+				if ((ox == 1 && oy == 1 && oz == 1) || neighbor == nullptr || neighbor->IsEmpty())
+					continue;
+				for (int x = 0; x < count[ox]; x++)
 				{
-					if (int maskVal = mask[i][j])
+					for (int y = 0; y < count[oy]; y++)
 					{
-						// find largest rect of same maskVal
-						int w = 1, h = 1;
-						while (j + w < CHUNK_VOXEL_SIZE && mask[i][j + w] == maskVal)
-						{
-							w++;
-						}
-						bool done = false;
-						while (i + h < CHUNK_VOXEL_SIZE && !done)
-						{
-							for (int k = 0; k < w; k++)
-							{
-								if (mask[i + h][j + k] != maskVal)
-								{
-									done = true;
-									break;
-								}
-							}
-							if (done)
-								break;
-							h++;
-						}
+						const BlockType* row = &neighbor->m_voxelData->m_voxels[theirStart[ox] + x][theirStart[oy] + y][theirStart[oz]];
+						std::copy(row, row + count[oz], &m_voxelData->m_voxels[ourStart[ox] + x][ourStart[oy] + y][ourStart[oz]]);
+					}
+				}
+			}
+		}
+	}
+}
+
+void Chunk::DirtyPlanes::AddVoxels(const glm::i32vec3& min, const glm::i32vec3& max)
+{
+	// an edited voxel only changes faces on the planes either side of it. ao reads the air layer next to a face,
+	// which is always one of those planes along some axis too
+	static_assert(CHUNK_VOXEL_SIZE < 64, "planes are tracked in a uint64_t");
+	for (int dim = 0; dim < 3; dim++)
+	{
+		const int firstPlane = std::max(min[dim], 0);
+		const int lastPlane = std::min(max[dim] + 1, int(CHUNK_VOXEL_SIZE));
+		if (lastPlane < firstPlane)
+			continue;
+		// bits firstPlane..lastPlane
+		const uint64_t upToLast = (lastPlane == 63) ? ~0ull : ((1ull << (lastPlane + 1)) - 1);
+		planes[dim] |= upToLast & ~((1ull << firstPlane) - 1);
+	}
+}
 
-						// generate face from found rect
-						x[u] = j;
-						x[v] = i;
+// runs on a worker with the edits already written. nothing that renders is touched until SwapInEditedMesh
+void Chunk::RemeshEdits(const DirtyPlanes& dirtyPlanes)
+{
+	// only air got written into an all air chunk
+	if (m_voxelData == nullptr)
+	{
+		m_editableMesh = std::make_unique<EditableMesh>();
+		m_editableMesh->fullUpload = true;
+		return;
+	}
 
-						glm::i32vec3 du(0, 0, 0);
-						du[u] = w;
-						glm::i32vec3 dv(0, 0, 0);
-						dv[v] = h;
+	if (!m_editableMesh)
+	{
+		// first edit on this chunk. full mesh, then keep it around so later edits only touch a few planes
+		m_editableMesh = std::make_unique<EditableMesh>();
+		uint faceOffsets[BlockFace::NumFaces + 1];
+		GreedyMesh(m_editableMesh->quads, faceOffsets, m_editableMesh->planeQuadOffsets);
+		m_editableMesh->fullUpload = true;
+		m_faceConnectivity = ComputeFaceConnectivity();
+		return;
+	}
 
-						const glm::vec3 vertices[2][4] = 
-						{
-							{
-								{x[0],					x[1],					x[2]},
-								{x[0] + dv[0],			x[1] + dv[1],			x[2] + dv[2]},
-								{x[0] + du[0] + dv[0],	x[1] + du[1] + dv[1],	x[2] + du[2] + dv[2]},
-								{x[0] + du[0],			x[1] + du[1],			x[2] + du[2]},
-							},
-							{
-								{x[0],					x[1],					x[2]},
-								{x[0] + du[0],			x[1] + du[1],			x[2] + du[2]},
-								{x[0] + du[0] + dv[0],	x[1] + du[1] + dv[1],	x[2] + du[2] + dv[2]},
-								{x[0] + dv[0],			x[1] + dv[1],			x[2] + dv[2]},
-							},
-						};
-
-						//// faces with maskVal 1 points in positive normal, 2 is negative, so have both windings
-						//static constexpr uint indices[2][6] = 
-						//{
-						//	{
-						//		0, 1, 3,
-						//		1, 2, 3
-						//	},
-						//	{
-						//		0, 3, 1,
-						//		1, 3, 2
-						//	},
-						//};
-
-						glm::vec3 normal = sweepDir;
-						int normalDir = maskVal % 2 == 1 ? 1 : 0;
-						if (normalDir == 1)
-							normal = -normal;
-
-						BlockFace b = BlockFace(dim * 2 + (normalDir));
-						BlockType blockType = BlockType(maskVal / 2);
-						// add faces
-						for (uint m = 0; m < 4; m++)
-						{
-							glm::uvec3 localVertexPos = vertices[normalDir][m];
-							uint packedVertex = (0x3F & localVertexPos.x) | (0xFC0 & (localVertexPos.y << 6)) | (0x3F000 & (localVertexPos.z << 12)) | (0x1C0000 & (b << 18)) | (0x1FE00000 & (uint8_t(blockType) << 21));
-							m_vertices.push_back(packedVertex);
-							//m_vertices.push_back(VertexPCN{ vertices[m], sweepDir, normal });
-						}
-						for (uint m = 0; m < 6; m++)
-						{
-							//m_indices.push_back(indices[maskVal - 1][m] + m_vertexCount);
-						}
-						m_indexCount += 6;
-						m_vertexCount += 4;
+	std::vector<PackedQuad> frontQuads;
+	std::vector<PackedQuad> backQuads;
+	for (int dim = 0; dim < 3; dim++)
+	{
+		for (int plane = 0; plane <= CHUNK_VOXEL_SIZE; plane++)
+		{
+			if (!(dirtyPlanes.planes[dim] & (1ull << plane)))
+				continue;
+			frontQuads.clear();
+			backQuads.clear();
+			GreedySweepPlane(dim, plane, frontQuads, backQuads);
+			SplicePlaneQuads(dim * 2, plane, frontQuads);
+			SplicePlaneQuads(dim * 2 + 1, plane, backQuads);
+		}
+	}
+	assert(m_editableMesh->planeQuadOffsets[BlockFace::NumFaces - 1][CHUNK_VOXEL_SIZE + 1] == m_editableMesh->quads.size());
+	// cheaper to assume the edit opened things up than to flood fill again
+	m_faceConnectivity = ALL_FACES_CONNECTED;
+}
 
-						//Zero-out mask
-						for (int l = 0; l < h; ++l)
-						{
-							for (int k = 0; k < w; ++k)
-							{
-								mask[i + l][j + k] = 0;
-							}
-						}
-						//Increment counters and continue
-						j += w;
-					}
-					else
+// main thread only, after RemeshEdits has finished
+void Chunk::SwapInEditedMesh()
+{
+	EditableMesh& mesh = *m_editableMesh;
+	const uint quadCount = uint(mesh.quads.size());
+	for (uint i = 0; i < BlockFace::NumFaces; i++)
+		m_faceQuadOffsets[i] = mesh.planeQuadOffsets[i][0];
+	m_faceQuadOffsets[BlockFace::NumFaces] = quadCount;
+	m_quadCount = quadCount;
+
+	if (quadCount)
+	{
+		if (m_VBO == 0)
+		{
+			glGenBuffers(1, &m_VBO);
+			s_bufferCreations++;
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_VBO);
+		if (mesh.fullUpload || quadCount > m_VBOCapacity)
+		{
+			// leave room so later edits can usually be patched in place
+			m_VBOCapacity = quadCount + quadCount / 4 + 256;
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_VBOCapacity * sizeof(PackedQuad), nullptr, GL_DYNAMIC_DRAW);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, quadCount * sizeof(PackedQuad), mesh.quads.data());
+		}
+		else
+		{
+			// only what the edits touched
+			const uint dirtyEnd = std::min(mesh.dirtyEnd, quadCount);
+			if (dirtyEnd > mesh.dirtyBegin)
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, mesh.dirtyBegin * sizeof(PackedQuad), (dirtyEnd - mesh.dirtyBegin) * sizeof(PackedQuad), mesh.quads.data() + mesh.dirtyBegin);
+		}
+	}
+	mesh.dirtyBegin = mesh.dirtyEnd = 0;
+	mesh.fullUpload = false;
+
+	std::lock_guard lock(m_mutex);
+	// whatever the generation pass made is out of date now
+	ReleaseQuads();
+	m_buffersGenerated = true;
+	m_meshGenerated = 1;
+	m_noGeo = quadCount == 0;
+	m_renderable = quadCount != 0;
+	m_state = ChunkState::Done;
+}
+
+bool Chunk::CanApplyEdits() const
+{
+	// done covers all air chunks too, they never get a mesh. edits also wait for any lod parent
+	// downsampling us to finish, it reads the volume and m_voxelData off the main thread
+	if (m_lodParentReaders.load() != 0)
+		return false;
+	return m_state == ChunkState::Done || (m_meshGenerated && m_state == ChunkState::GeneratingBuffers);
+}
+
+// flood fill the air in our interior and record which faces can see each other through it.
+// https://tomcc.github.io/2014/08/31/visibility-1.html
+uint64_t Chunk::ComputeFaceConnectivity() const
+{
+	if (IsEmpty())
+		return ALL_FACES_CONNECTED;
+
+	constexpr int CHUNK_VOLUME = CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE;
+	static_assert(CHUNK_VOLUME <= (1 << 16));
+
+	uint64_t visited[CHUNK_VOLUME / 64] = { 0 };
+	uint16_t queue[CHUNK_VOLUME];
+	uint64_t connectivity = 0;
+
+	auto isVisitable = [&](int x, int y, int z)
+	{
+		const int index = x + CHUNK_VOXEL_SIZE * (y + CHUNK_VOXEL_SIZE * z);
+		if (visited[index / 64] & (1ull << (index % 64)))
+			return false;
+		if (BlockIsOpaque(m_voxelData->m_voxels[x + 1][y + 1][z + 1]))
+			return false;
+		visited[index / 64] |= 1ull << (index % 64);
+		return true;
+	};
+
+	constexpr int last = CHUNK_VOXEL_SIZE - 1;
+	for (int z = 0; z < CHUNK_VOXEL_SIZE; z++)
+	{
+		for (int y = 0; y < CHUNK_VOXEL_SIZE; y++)
+		{
+			for (int x = 0; x < CHUNK_VOXEL_SIZE; x++)
+			{
+				// air pockets that dont touch a face cant connect anything, only seed from the border
+				if (x != 0 && x != last && y != 0 && y != last && z != 0 && z != last)
+					continue;
+				if (!isVisitable(x, y, z))
+					continue;
+
+				uint faces = 0;
+				int head = 0;
+				int tail = 0;
+				queue[tail++] = uint16_t(x + CHUNK_VOXEL_SIZE * (y + CHUNK_VOXEL_SIZE * z));
+				while (head < tail)
+				{
+					const int index = queue[head++];
+					const int cx = index % CHUNK_VOXEL_SIZE;
+					const int cy = (index / CHUNK_VOXEL_SIZE) % CHUNK_VOXEL_SIZE;
+					const int cz = index / (CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE);
+
+					faces |= (cx == last) << BlockFace::Right;
+					faces |= (cx == 0) << BlockFace::Left;
+					faces |= (cy == last) << BlockFace::Top;
+					faces |= (cy == 0) << BlockFace::Bottom;
+					faces |= (cz == last) << BlockFace::Front;
+					faces |= (cz == 0) << BlockFace::Back;
+
+					for (uint i = 0; i < BlockFace::NumFaces; i++)
 					{
-						j++;  
+						const int nx = cx + int(s_blockNormals[i].x);
+						const int ny = cy + int(s_blockNormals[i].y);
+						const int nz = cz + int(s_blockNormals[i].z);
+						if (nx < 0 || ny < 0 || nz < 0 || nx > last || ny > last || nz > last)
+							continue;
+						if (isVisitable(nx, ny, nz))
+							queue[tail++] = uint16_t(nx + CHUNK_VOXEL_SIZE * (ny + CHUNK_VOXEL_SIZE * nz));
 					}
 				}
+
+				for (uint a = 0; a < BlockFace::NumFaces; a++)
+				{
+					if (faces & (1u << a))
+						connectivity |= uint64_t(faces) << (a * BlockFace::NumFaces);
+				}
+				if (connectivity == ALL_FACES_CONNECTED)
+					return connectivity;
 			}
 		}
 	}
+	return connectivity;
 }
 
 int Chunk::ConvertDirToNeighborIndex(const glm::vec3& dir)
@@ -6,15 +6,22 @@
 #include <functional>
 #include <unordered_map>
 #include <thread>
+#include <memory>
+#include <climits>
+#include <chrono>
 
 #include "Common.h"
 #include "RenderSettings.h"
 #include <FastNoise/FastNoise.h>
 
+class NoiseColumnCache;
+
 class Chunk
 {
 public:
 	static const int INT_CHUNK_VOXEL_SIZE = CHUNK_VOXEL_SIZE + 2;
+	// bit (a * NumFaces + b) is set when face a can see face b through air
+	static constexpr uint64_t ALL_FACES_CONNECTED = (1ull << (BlockFace::NumFaces * BlockFace::NumFaces)) - 1;
 
 	struct ChunkGenParams
 	{
@@ -24,6 +31,24 @@ public:
 		float terrainGain = 0.4f;
 		float terrainFrequency = 0.1f;
 		int terrainOctaves = 4;
+		bool ambientOcclusion = true;
+		// build lod n volumes out of resident lod n - 1 children instead of sampling noise
+		bool downsampleLODs = true;
+		// skip the 3d grids for chunks a coarse sample says are all air or all solid.
+		// how far a voxel can be from its nearest sample comes from each steps lipschitz estimate. thats measured, not
+		// derived from the node tree, so a node steeper somewhere the measurement didnt look can drop real terrain. off until theres a real bound
+		bool classifyVolumes = false;
+		// sample the density every 4th voxel and trilinearly fill cells that are clearly air or solid.
+		// cells with a corner within adaptiveDensityError of 0 get every voxel sampled
+		bool adaptiveDensity = false;
+		float adaptiveDensityError = 0.1f;
+		// lod profile. layers past these lods get cheaper or dropped, on top of whatever the terrain graph prunes.
+		// caves are a few voxels across up close and disappear into single far voxels
+		int caveMaxLOD = 6;
+		// caves above this lod are only sampled every 4th voxel and interpolated
+		int caveCoarseLOD = 4;
+		int biomeMaxLOD = 8;
+		int dirtMaxLOD = 8;
 
 #ifdef DEBUG
 		bool m_debugFlatWorld = true;
@@ -39,6 +64,15 @@ public:
 				terrainGain != rhs.terrainGain ||
 				terrainFrequency != rhs.terrainFrequency ||
 				terrainOctaves != rhs.terrainOctaves ||
+				ambientOcclusion != rhs.ambientOcclusion ||
+				downsampleLODs != rhs.downsampleLODs ||
+				classifyVolumes != rhs.classifyVolumes ||
+				adaptiveDensity != rhs.adaptiveDensity ||
+				adaptiveDensityError != rhs.adaptiveDensityError ||
+				caveMaxLOD != rhs.caveMaxLOD ||
+				caveCoarseLOD != rhs.caveCoarseLOD ||
+				biomeMaxLOD != rhs.biomeMaxLOD ||
+				dirtMaxLOD != rhs.dirtMaxLOD ||
 				m_debugFlatWorld != rhs.m_debugFlatWorld;
 		}
 	};
@@ -76,44 +110,121 @@ public:
 		Done
 	};
 
+	// one record per quad, expanded into 6 vertices in terrain.vs.glsl
+	// position:	x 6 | y 6 | z 6 | width - 1 5 | height - 1 5 | face 3 | 1 spare
+	// attributes:	blockType 8 | ao 8 | 16 spare
+	// ao is 2 bits per corner, corner (u, v) at bit (u + v * 2) * 2. 3 is unoccluded
+	struct PackedQuad
+	{
+		uint position;
+		uint attributes;
+	};
+	// every voxel boundary in the volume, including against the border, gives at most one quad.
+	// a 3d checkerboard hits this
+	static constexpr uint MAX_QUADS = 3 * (CHUNK_VOXEL_SIZE + 1) * CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE;
+
 	struct VoxelData
 	{
 		BlockType m_voxels[INT_CHUNK_VOXEL_SIZE][INT_CHUNK_VOXEL_SIZE][INT_CHUNK_VOXEL_SIZE] = { BlockType(0) };
+		// bit z of [x][y] is set when the chunks own voxel x, y, z is collideable. built once the volume is generated and
+		// kept up to date by every write after that, so collision never has to look at the voxels themselves
+		uint32_t m_collisionRows[CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE] = { 0 };
+	};
+	static_assert(CHUNK_VOXEL_SIZE == 32, "collision rows are a uint32_t");
+	// bit x of [z][y] is set when that voxel is opaque. rows run along x so z slabs never write the same one
+	using OpaqueRows = uint64_t[INT_CHUNK_VOXEL_SIZE][INT_CHUNK_VOXEL_SIZE];
+	static_assert(INT_CHUNK_VOXEL_SIZE <= 64, "opaque rows are a uint64_t");
+
+	// the grids noise generation fills, one step in the plan each
+	enum NoiseOutput : uint
+	{
+		Noise_Height = 0,
+		Noise_Dirt,
+		Noise_Biome,
+		Noise_Density,
+		Noise_Cave,
+
+		Num_NoiseOutputs,
 	};
 
+	// a terrain graph compiled down to what GenerateVolume runs, see TerrainGraph
 	struct ChunkNoiseGenerators
 	{
-		FastNoise::SmartNode<> noiseGenerator; 
-		FastNoise::SmartNode<> noiseGeneratorCave;
-		FastNoise::SmartNode<> biomeGenerator;
+		struct Step
+		{
+			// steps with the same node tree share one generator
+			FastNoise::SmartNode<> generator;
+			float frequency = 1.0f;
+			int seed = 1337;
+			// pruned above this lod, the grid is just filled with fill
+			uint maxLOD = UINT_MAX;
+			float fill = 0.0f;
+			// roughly how much the generator changes per unit of its input, measured by TerrainGraph for the 3d outputs. an estimate, not a bound
+			float lipschitz = 0.0f;
+
+			bool IsPruned(uint lod) const { return !generator || lod > maxLOD; }
+		};
+
+		// biome noise below maxValue, in order
+		struct BiomeBand
+		{
+			float maxValue;
+			BlockType block;
+		};
+
+		Step steps[Num_NoiseOutputs];
+		std::vector<BiomeBand> biomes;
+		// solid voxels with solid above them
+		BlockType subsurfaceBlock = BlockType::Stone;
 	};
 
+	using ParallelForFunction = std::function<void(uint, const std::function<void(uint)>&)>;
+
 	static void InitShared(
 		std::unordered_map<std::thread::id, int>& threadIDs, 
 		std::function<void(Chunk*)> generateMeshCallback, 
 		std::function<void(Chunk*)> renderListCallback,
-		const ChunkGenParams* chunkGenParams
+		const ChunkGenParams* chunkGenParams,
+		// runs on the worker once noise is in the volume, before meshing. can write with WriteVoxelRow
+		std::function<void(Chunk*)> volumeGeneratedCallback = nullptr,
+		// runs the noise grids of a chunk as sub-jobs. without it they run one after another
+		ParallelForFunction parallelFor = nullptr
 	);
 	static void DeleteShared();
+	static NoiseColumnCache& GetNoiseColumnCache();
+	// cpu side storage of generated meshes that havent been uploaded yet, across every chunk
+	static size_t GetResidentQuadBytes();
+	// gl buffers created over the lifetime of the program
+	static uint64_t GetBufferCreations();
 
 	//bool BlockIsOpaque(BlockType t);
 
-	void GetModelMat(glm::mat4& mat) { mat = m_modelMat; }
-	//float* GetVertexData() { return (float*)(m_vertices.data()); }
-	//uint* GetIndexData() { return m_indices.data(); }
-	uint GetVertexCount() { return m_vertexCount; }
-	uint GetIndexCount() { return m_indexCount; }
-	const AABB& GetBoundingBox() const { return m_AABB; }
+	uint GetQuadCount() const { return m_quadCount; }
+	const std::vector<PackedQuad>& GetQuads() const { return m_quads; }
+	// built from m_chunkPos and m_scale, chunks dont keep one around
+	AABB GetBoundingBox() const { return AABB(m_chunkPos, m_chunkPos + glm::vec3(GetUnitSize())); }
+	// world units along each side
+	float GetUnitSize() const { return CHUNK_UNIT_SIZE * m_scale; }
 	const uint GetLOD() const { return m_LOD; }
 	const float GetScale() const { return m_scale; }
-	bool IsDeletable() const { return m_state == ChunkState::Done || m_state == ChunkState::GeneratingBuffers; }
+	// nothing else is still using us. whether the volume can be read is IsMeshReady
+	bool IsDeletable() const { return !m_editsPending && (m_state == ChunkState::Done || m_state == ChunkState::GeneratingBuffers); }
 	bool IsBrandNew() const { return m_state == ChunkState::BrandNew; }
+	// has a mesh to draw, or never will. the generation job, overlay writes included, is done with the volume by then, so from
+	// here on only main thread edits write it and its safe to read there. cant go true any earlier without making those reads a race.
+	// whether anything else still needs us is up to the epoch reclaimer
+	bool IsMeshReady() const { return m_state == ChunkState::Done || m_state == ChunkState::GeneratingBuffers; }
+	// out of the octree and waiting to be reclaimed. set on the main thread, jobs check it to skip work nobody will see
+	bool IsRetired() const { return m_retired.load(); }
+	void SetRetired() { m_retired = true; }
 	bool IsDone() const { return m_state == ChunkState::Done; }
 	glm::vec3 GetChunkPos() { return m_chunkPos; }
 
 	BlockType GetBlockType(uint x, uint y, uint z) const;
 	bool VoxelIsCollideable(const glm::i32vec3& index) const;
 	bool VoxelIsCollideableAtWorldPos(const glm::vec3& worldPos) const;
+	// bit z set where VoxelIsCollideable({ x, y, z }), for the chunks own voxels
+	uint32_t GetCollisionRow(int x, int y) const { return m_empty ? 0 : m_voxelData->m_collisionRows[x][y]; }
 	ChunkState GetChunkState() const;
 	bool GetVoxelIndexAtWorldPos(const glm::vec3& worldPos, glm::i32vec3& voxelIndex);
 	BlockType GetBlockTypeAtWorldPos(const glm::vec3& worldPos);
@@ -122,15 +233,46 @@ public:
 	void DeleteBlockAtIndex(const glm::i8vec3& index);
 	void DeleteBlockAtInternalIndex(const glm::i8vec3& index);
 	void ReplaceBlockAtIndex(const glm::i8vec3& index, BlockType b);
+	// writes length voxels along z starting at start (-1 and CHUNK_VOXEL_SIZE are the border). z is the innermost axis
+	// so this is one contiguous fill. all air chunks get a volume allocated the first time something solid is written
+	void WriteVoxelRow(const glm::i32vec3& start, int length, BlockType type);
+	// an all air chunk has no volume, so the first solid WriteVoxelRow would leave its border air even where a neighbor is solid.
+	// ProcessEdits calls this first to copy the border in from the neighbors, indexed by their offset from us + 1. nullptr reads as air
+	void CopyBorderFromNeighbors(const Chunk* neighbors[3][3][3]);
+
+	// planes touched by a batch of edits, bit k of axis a is the plane between voxels k - 1 and k along a
+	struct DirtyPlanes
+	{
+		uint64_t planes[3] = { 0, 0, 0 };
+		// min/max are an inclusive box of edited voxels
+		void AddVoxels(const glm::i32vec3& min, const glm::i32vec3& max);
+	};
+
+	// edit remeshing, driven by VoxelScene::ProcessEdits.
+	// RemeshEdits runs on a worker after the edited voxels were written. it only re-sweeps dirtyPlanes,
+	// the first edit on a chunk does a full mesh to get started.
+	// the old mesh keeps rendering until SwapInEditedMesh on the main thread
+	void RemeshEdits(const DirtyPlanes& dirtyPlanes);
+	void SwapInEditedMesh();
+	bool CanApplyEdits() const;
+	void SetEditsPending(bool pending) { m_editsPending = pending; }
+	uint GetEditedQuadCount() const { return m_editableMesh ? uint(m_editableMesh->quads.size()) : 0; }
+	// laid out like GetQuads, faces in order and each faces planes in order
+	const std::vector<PackedQuad>* GetEditedQuads() const { return m_editableMesh ? &m_editableMesh->quads : nullptr; }
 
 	bool IsEmpty() const { return bool(m_empty); }
 	bool IsNoGeo() const { return bool(m_noGeo); }
 	bool Renderable() const; // can we turn our render chunks back into const Chunk*?
 
-	void Render(RenderSettings::DrawMode drawMode);
+	uint Render(RenderSettings::DrawMode drawMode, const glm::vec3& cameraPos);
+	// generated meshes wait for the main thread to put them in their buffer, see RenderSettings::stagedUploads
+	bool NeedsUpload() const;
+	uint GetUploadBytes() const { return m_quadCount * sizeof(PackedQuad); }
+	// main thread only
+	void UploadMesh();
+	std::chrono::high_resolution_clock::time_point GetMeshCompleteTime() const { return m_meshCompleteTime; }
 	bool UpdateNeighborRefs(const Chunk* neighbors[BlockFace::NumFaces]);
 	bool UpdateNeighborRef(BlockFace face, Chunk* neighbor);
-	bool UpdateNeighborRefNewChunk(BlockFace face, Chunk* neighbor);
 	void NotifyNeighborOfVolumeGeneration(BlockFace neighbor);
 	void GetNoiseGenPos(
 		const glm::vec3& chunkPos, 
@@ -140,15 +282,47 @@ public:
 		float& frequency);
 	void GenerateVolume(const ChunkNoiseGenerators* generators);
 	void GenerateVolume2();
-	void GenerateMesh();
+	// fills the volume, border included, from fn(x, y, z) with x/y/z in [-1, CHUNK_VOXEL_SIZE]. doesnt mesh
+	void GenerateVolumeFromFunction(const std::function<BlockType(int, int, int)>& fn);
+	// opaqueRows is optional. classification passes the rows it built, so the mesher can skip planes without anything in them
+	void GenerateMesh(const OpaqueRows* opaqueRows = nullptr);
 	void SetNeedsLODSeam(BlockFace f);
+	// the chunks of our octree nodes children, in octree child order, for GenerateVolume to downsample.
+	// they cant be deleted until we're done generating. main thread only
+	void SetLODChildren(Chunk* const children[8]);
+	// lets go of them again, done by GenerateVolume or whoever skips it
+	void ReleaseLODChildren();
 	static void SetTerrainParams(float lacunarity, float gain, int octaves);
 
 	bool IsInFrustum(const Frustum& f) const;
+	bool FacesConnected(BlockFace a, BlockFace b) const { return (m_faceConnectivity.load() >> (a * BlockFace::NumFaces + b)) & 1u; }
 
+	// hot data first. culling, cave visibility, the upload queue and drawing only read from here to m_faceConnectivity,
+	// so walking a frames leaves touches 72 bytes of each chunk instead of all of it
 	// worldspace chunk pos. bottom most corner
 	glm::vec3 m_chunkPos = glm::vec3(0, 0, 0);
+	// visibility traversal bookkeeping. only touched on the main thread
+	uint m_visibilityFrame = 0;
+	uint8_t m_visibilityEntryMask = 0;
+private:
+	uint8_t m_LOD = 0;
+	std::atomic<ChunkState> m_state = ChunkState::BrandNew;
+	float m_scale = 0;
+	uint m_VBO = 0;
+	uint m_quadCount = 0;
+	// quads are grouped by BlockFace, face i lives in [m_faceQuadOffsets[i], m_faceQuadOffsets[i + 1])
+	uint m_faceQuadOffsets[BlockFace::NumFaces + 1] = { 0 };
+	std::atomic<bool> m_renderable = false;
+	uint8_t m_meshGenerated		: 1 = 0;
+	uint8_t m_buffersGenerated	: 1 = 0;
+	uint8_t m_empty				: 1 = 1;
+	uint8_t m_noGeo				: 1 = 0;	// could this be combined with m_empty? probably
+	uint8_t m_needsLODSeam		: 1 = 0;
+	// assume everything is visible through us until the mesh pass says otherwise
+	std::atomic<uint64_t> m_faceConnectivity = ALL_FACES_CONNECTED;
 
+public:
+	// cold from here on
 	std::mutex m_mutex;
 
 	double m_genTime = 0.0f;
@@ -160,14 +334,81 @@ public:
 		float noise2D1[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
 		float noise2D2[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
 		float noise2D3[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		// lod skirts, 4 samples for each voxel on a border face. corners and edges dont get skirts
+		static constexpr uint MAX_SKIRT_VOXELS = BlockFace::NumFaces * CHUNK_VOXEL_SIZE * CHUNK_VOXEL_SIZE;
+		float skirtSampleX[MAX_SKIRT_VOXELS * 4];
+		float skirtSampleY[MAX_SKIRT_VOXELS * 4];
+		float skirtSampleZ[MAX_SKIRT_VOXELS * 4];
+		float skirtNoise[MAX_SKIRT_VOXELS * 4];
+		uint16_t skirtVoxels[MAX_SKIRT_VOXELS];
+		// voxels GenerateGridAdaptive couldnt interpolate
+		float adaptiveSampleX[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		float adaptiveSampleY[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		float adaptiveSampleZ[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		float adaptiveSamples[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		uint16_t adaptiveSampleVoxels[INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE * INT_CHUNK_VOXEL_SIZE];
+		// what classification just wrote, handed straight to the mesher. only valid while opaqueRowsChunk is the chunk being generated
+		OpaqueRows opaqueRows;
+		const Chunk* opaqueRowsChunk = nullptr;
+		// quads get swept in here per axis and direction, then copied out once the chunks count is known. only ever grows
+		std::vector<PackedQuad> meshStaging[3][2];
 	};
 	static ScratchpadMemoryLayout* s_scratchpadMemory;
 
 private:
 	void GenerateMeshInt();
-	void GenerateGreedyMeshInt();
+	void GenerateGreedyMeshInt(const OpaqueRows* opaqueRows);
+	// bit k of facePlanes[dim] is set when plane k along dim has any faces in it
+	static void GetFacePlanes(const OpaqueRows& opaqueRows, uint64_t facePlanes[3]);
+	// lays axisQuads out in m_quads the way GreedyMesh does, allocating it once
+	void SpliceAxisQuads(const std::vector<PackedQuad> (&axisQuads)[3][2]);
+	// m_quads only ever gets exactly quadCount of storage, and gives all of it back once the mesh is uploaded
+	void AllocateQuads(size_t quadCount);
+	void ReleaseQuads();
+	void GreedyMesh(std::vector<PackedQuad>& quads, uint faceOffsets[BlockFace::NumFaces + 1], uint (*planeOffsets)[CHUNK_VOXEL_SIZE + 2]) const;
+	void GreedySweepPlane(int dim, int plane, std::vector<PackedQuad>& frontQuads, std::vector<PackedQuad>& backQuads) const;
+	void SplicePlaneQuads(uint face, int plane, const std::vector<PackedQuad>& quads);
+	// an all air volume for an all air chunk thats getting edited
+	void CreateEditVolume();
+	// same blocks as VoxelIsCollideable, which are everything from dirt to blue
+	static bool IsCollideable(BlockType type) { return type >= BlockType::Dirt && type <= BlockType::Blue; }
+	// m_collisionRows from scratch, once the volume is generated
+	void BuildCollisionRows();
+	// keeps m_collisionRows in step with type being written to the voxels zBegin to zEnd inclusive of row x, y. border voxels arent in it
+	void UpdateCollisionRow(int x, int y, int zBegin, int zEnd, BlockType type);
+
+	// both return whether the volume came out all air
+	bool GenerateVolumeFromNoise(const ChunkNoiseGenerators* generators);
+	// false if any child isnt generated yet
+	bool GenerateVolumeFromChildren(bool& empty);
+	enum class VolumeClass : uint8_t
+	{
+		Mixed,
+		Air,
+		Solid,
+	};
+	VolumeClass ClassifyVolume(const ChunkNoiseGenerators* generators, const glm::ivec3& noiseStartPos, float frequencyScale) const;
+	// fills a 3d grid like GenUniformGrid3D would, x fastest. samples every 4th voxel and only refines cells with a corner within error of 0,
+	// -infinity never refines
+	void GenerateGridAdaptive(const ChunkNoiseGenerators::Step& step, const glm::ivec3& noiseStartPos, float frequencyScale, float error, float* grid) const;
+	// pruned by the terrain graph or the gen params lod profile
+	bool IsNoiseStepPruned(const ChunkNoiseGenerators* generators, NoiseOutput output) const;
+	// runs one step of the plan into its grid. frequencyScale is the chunks, before the step scales it.
+	// 3d grids can be done a z slab at a time, unless theyre adaptive
+	void GenerateNoiseGrid(const ChunkNoiseGenerators* generators, NoiseOutput output, const glm::ivec3& noiseStartPos, float frequencyScale, float* grid,
+		int zBegin = 0, int zEnd = INT_CHUNK_VOXEL_SIZE) const;
+	bool IsNoiseGridAdaptive(NoiseOutput output) const;
+	// lod 0 chunks split noise and voxel classification into z slabs run as sub-jobs, see RenderSettings::generationSlabs
+	int GetGenerationSlabs() const;
+	static int GetSlabBegin(int slab, int slabs);
+	// where a slab starting at zBegin puts its skirts in the scratch skirt lists
+	static uint GetSkirtSlabOffset(int zBegin);
+	// classifies voxels in z range zBegin..zEnd from the noise grids in scratchMem, returns true if theyre all air
+	bool GenerateVolumeSlab(const ChunkNoiseGenerators* generators, ScratchpadMemoryLayout& scratchMem, int zBegin, int zEnd);
 
 	int ConvertDirToNeighborIndex(const glm::vec3& dir);
+	uint ComputeFaceAO(const glm::i32vec3& airVoxel, int u, int v) const;
+	uint64_t ComputeFaceConnectivity() const;
 	
 	inline bool AllNeighborsGenerated() const { return m_neighborGeneratedMask == 0x3f; }
 
@@ -177,35 +418,39 @@ private:
 	// maybe dont need to store the extra edges all the time?
 	VoxelData* m_voxelData = nullptr;
 
-	//TODO:: call reserve on these with some sane value
-	std::vector<uint> m_vertices = std::vector<uint>();
-	// is there some way to get rid of this... this is a lot of data that is relatively static
-	//std::vector<uint> m_indices = std::vector<uint>();
-
-	// testing with these being atomic. dunno if its better/worse/blegh
-	std::atomic<Chunk*> m_neighbors[BlockFace::NumFaces] = { nullptr };
+	// sized exactly by AllocateQuads, empty again after upload
+	std::vector<PackedQuad> m_quads = std::vector<PackedQuad>();
 
-	AABB m_AABB;
-	glm::mat4 m_modelMat;
-	uint m_LOD = 0;
-	float m_scale = 0;
+	// only exists once a chunk has been edited. a cpu copy of the mesh that edits get patched into
+	struct EditableMesh
+	{
+		std::vector<PackedQuad> quads;
+		// face f, plane k lives in [planeQuadOffsets[f][k], planeQuadOffsets[f][k + 1]). plane k sits between voxels k - 1 and k
+		uint planeQuadOffsets[BlockFace::NumFaces][CHUNK_VOXEL_SIZE + 2] = { 0 };
+		// quads changed since the last upload
+		uint dirtyBegin = 0;
+		uint dirtyEnd = 0;
+		bool fullUpload = false;
+	};
+	std::unique_ptr<EditableMesh> m_editableMesh;
+	// VoxelScene has edits queued or remeshing for us, main thread only
+	bool m_editsPending = false;
+	std::atomic<bool> m_retired = false;
 
-	uint m_vertexCount = 0;
-	uint m_indexCount = 0;
+	// indexed by octant, x * 4 + y * 2 + z with 1 being the positive half
+	Chunk* m_lodChildren[8] = { nullptr };
+	// lod parents that are going to downsample us
+	std::atomic<uint8_t> m_lodParentReaders = 0;
 
-	uint m_VBO = 0;
-	uint m_EBO = 0;
+	// in quads. edits give it some headroom so most of them fit, recycled chunks reuse it
+	uint m_VBOCapacity = 0;
+	// when the last generated mesh was ready for upload
+	std::chrono::high_resolution_clock::time_point m_meshCompleteTime;
 
-	std::atomic<ChunkState> m_state = ChunkState::BrandNew;
 	std::atomic<uint8_t> m_neighborGeneratedMask = 0;
 	std::atomic<bool> m_generated = false;
-	std::atomic<bool> m_renderable = false;
+	// set by WriteVoxelRow, GenerateVolume cant hand the mesher its opaque rows once the callback has written over them
+	bool m_voxelRowsWritten = false;
 
 	BlockFace m_LODSeamDir = BlockFace::Right;
-
-	uint m_meshGenerated	: 1 = 0;
-	uint m_buffersGenerated : 1 = 0;
-	uint m_empty			: 1 = 1;
-	uint m_noGeo			: 1 = 0;	// could this be combined with m_empty? probably
-	uint m_needsLODSeam		: 1 = 0;
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "ChunkPool.h"
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+ChunkPool::~ChunkPool()
+{
+	Clear();
+}
+
+Chunk* ChunkPool::New(const glm::vec3& chunkPos, uint lod)
+{
+	if (m_free.empty())
+	{
+		m_stats.allocations++;
+		return new Chunk(chunkPos, lod);
+	}
+
+	Chunk* chunk = m_free.back();
+	m_free.pop_back();
+	chunk->CreateResources(chunkPos, lod);
+	m_stats.reuses++;
+	return chunk;
+}
+
+void ChunkPool::Free(Chunk* chunk)
+{
+	ZoneScoped;
+	if (m_free.size() >= MAX_FREE_CHUNKS)
+	{
+		m_stats.deletes++;
+		delete chunk;
+		return;
+	}
+	chunk->ReleaseResources();
+	m_free.push_back(chunk);
+}
+
+void ChunkPool::Clear()
+{
+	for (Chunk* chunk : m_free)
+		delete chunk;
+	m_stats.deletes += m_free.size();
+	m_free.clear();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+#include "Chunk.h"
+
+// chunks the octree dropped, kept for the next split or merge instead of going through new/delete.
+// a recycled chunk keeps its gpu buffer name and capacity, everything else goes back to how a new chunk starts.
+// main thread only
+class ChunkPool
+{
+public:
+	// past this, freed chunks really get deleted so a big jump doesnt leave buffers sitting around forever
+	static constexpr size_t MAX_FREE_CHUNKS = 8192;
+
+	struct Stats
+	{
+		// new Chunk, vs handed back out of the pool
+		uint64_t allocations = 0;
+		uint64_t reuses = 0;
+		uint64_t deletes = 0;
+	};
+
+	ChunkPool() = default;
+	ChunkPool(const ChunkPool&) = delete;
+	ChunkPool& operator=(const ChunkPool&) = delete;
+	~ChunkPool();
+
+	Chunk* New(const glm::vec3& chunkPos, uint lod);
+	// nobody can be holding chunk anymore. its voxels and cpu mesh go back right away
+	void Free(Chunk* chunk);
+	// deletes everything waiting to be reused, gl buffers included
+	void Clear();
+
+	const Stats& GetStats() const { return m_stats; }
+	size_t GetFreeCount() const { return m_free.size(); }
+
+private:
+	std::vector<Chunk*> m_free;
+	Stats m_stats;
+};
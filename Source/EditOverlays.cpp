@@ -0,0 +1,230 @@
+#include "EditOverlays.h"
+#include <glm/common.hpp>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+glm::i32vec3 EditOverlays::GetKey(const glm::vec3& chunkPos, uint level)
+{
+	// chunk positions are always a multiple of their size, round just guards against float noise
+	return glm::i32vec3(glm::round(chunkPos / float(CHUNK_UNIT_SIZE << level)));
+}
+
+glm::vec3 EditOverlays::GetChunkCenter(const glm::i32vec3& key, uint level)
+{
+	return (glm::vec3(key) + 0.5f) * float(CHUNK_UNIT_SIZE << level);
+}
+
+void EditOverlays::Apply(const std::vector<KeyedRow>& lod0Rows, std::vector<LevelChange>& changes)
+{
+	ZoneScoped;
+	std::lock_guard lock(m_mutex);
+
+	std::unordered_map<glm::i32vec3, ChangedBox> changed;
+	for (const KeyedRow& keyedRow : lod0Rows)
+	{
+		const Row& row = keyedRow.row;
+		const int x = row.start.x;
+		const int y = row.start.y;
+		if (x < 0 || x >= CHUNK_VOXEL_SIZE || y < 0 || y >= CHUNK_VOXEL_SIZE)
+			continue;
+
+		Overlay& overlay = GetOverlay(0, keyedRow.key);
+		uint32_t& mask = overlay.m_mask[x][y];
+		const int zEnd = std::min(row.start.z + row.length, CHUNK_VOXEL_SIZE);
+		for (int z = std::max(row.start.z, 0); z < zEnd; z++)
+		{
+			if (((mask >> z) & 1u) && overlay.m_voxels[x][y][z] == row.type)
+				continue;
+			mask |= 1u << z;
+			overlay.m_voxels[x][y][z] = row.type;
+			changed[keyedRow.key].Add({ x, y, z });
+		}
+	}
+
+	// walk up a level at a time, only re-reducing the parent voxels over changed child voxels.
+	// stops as soon as a level comes out the same
+	std::unordered_map<glm::i32vec3, ChangedBox> parentChanged;
+	for (uint level = 1; level < NUM_LEVELS && !changed.empty(); level++)
+	{
+		parentChanged.clear();
+		for (const auto& [key, box] : changed)
+		{
+			const Overlay& child = *m_levels[level - 1][key];
+			const glm::i32vec3 parentKey(key.x >> 1, key.y >> 1, key.z >> 1);
+			const glm::i32vec3 octantOffset = (key - parentKey * 2) * (CHUNK_VOXEL_SIZE / 2);
+			// dont allocate parents for edits too small to show up in them
+			auto parentIt = m_levels[level].find(parentKey);
+			Overlay* parent = parentIt != m_levels[level].end() ? parentIt->second.get() : nullptr;
+
+			const glm::i32vec3 minIndex = octantOffset + box.min / 2;
+			const glm::i32vec3 maxIndex = octantOffset + box.max / 2;
+			for (int x = minIndex.x; x <= maxIndex.x; x++)
+			{
+				for (int y = minIndex.y; y <= maxIndex.y; y++)
+				{
+					for (int z = minIndex.z; z <= maxIndex.z; z++)
+					{
+						Chunk::BlockType type;
+						if (!ReduceVoxel(child, (glm::i32vec3(x, y, z) - octantOffset) * 2, type))
+							continue;
+						if (parent == nullptr)
+							parent = &GetOverlay(level, parentKey);
+						uint32_t& mask = parent->m_mask[x][y];
+						if (((mask >> z) & 1u) && parent->m_voxels[x][y][z] == type)
+							continue;
+						mask |= 1u << z;
+						parent->m_voxels[x][y][z] = type;
+						parentChanged[parentKey].Add({ x, y, z });
+					}
+				}
+			}
+		}
+
+		// the chunk at this level and any neighbor keeping the changed voxels in its border
+		for (const auto& [key, box] : parentChanged)
+		{
+			const Overlay& overlay = *m_levels[level][key];
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dz = -1; dz <= 1; dz++)
+					{
+						const glm::i32vec3 dir(dx, dy, dz);
+						LevelChange change = { level, key + dir, {} };
+						GetChunkRows(overlay, dir * CHUNK_VOXEL_SIZE, box, change.rows);
+						if (!change.rows.empty())
+							changes.push_back(std::move(change));
+					}
+				}
+			}
+		}
+		changed.swap(parentChanged);
+	}
+}
+
+void EditOverlays::WriteIntoChunk(Chunk* chunk)
+{
+	ZoneScoped;
+	const uint level = chunk->GetLOD();
+	if (level >= NUM_LEVELS)
+		return;
+
+	const glm::i32vec3 key = GetKey(chunk->GetChunkPos(), level);
+	std::vector<Row> rows;
+	{
+		std::lock_guard lock(m_mutex);
+		const auto& overlays = m_levels[level];
+		if (overlays.empty())
+			return;
+
+		const ChangedBox wholeOverlay = { glm::i32vec3(0), glm::i32vec3(CHUNK_VOXEL_SIZE - 1) };
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dz = -1; dz <= 1; dz++)
+				{
+					const glm::i32vec3 dir(dx, dy, dz);
+					auto it = overlays.find(key + dir);
+					if (it != overlays.end())
+						GetChunkRows(*it->second, -dir * CHUNK_VOXEL_SIZE, wholeOverlay, rows);
+				}
+			}
+		}
+	}
+
+	for (const Row& row : rows)
+		chunk->WriteVoxelRow(row.start, row.length, row.type);
+}
+
+void EditOverlays::Clear()
+{
+	std::lock_guard lock(m_mutex);
+	for (auto& overlays : m_levels)
+		overlays.clear();
+}
+
+size_t EditOverlays::GetOverlayCount()
+{
+	std::lock_guard lock(m_mutex);
+	size_t count = 0;
+	for (const auto& overlays : m_levels)
+		count += overlays.size();
+	return count;
+}
+
+EditOverlays::Overlay& EditOverlays::GetOverlay(uint level, const glm::i32vec3& key)
+{
+	std::unique_ptr<Overlay>& overlay = m_levels[level][key];
+	if (overlay == nullptr)
+		overlay = std::make_unique<Overlay>();
+	return *overlay;
+}
+
+bool EditOverlays::ReduceVoxel(const Overlay& child, const glm::i32vec3& childIndex, Chunk::BlockType& type) const
+{
+	int edited = 0;
+	int solid = 0;
+	Chunk::BlockType solidType = Chunk::BlockType::Air;
+	for (int dx = 0; dx < 2; dx++)
+	{
+		for (int dy = 0; dy < 2; dy++)
+		{
+			const uint32_t bits = (child.m_mask[childIndex.x + dx][childIndex.y + dy] >> childIndex.z) & 3u;
+			for (int dz = 0; dz < 2; dz++)
+			{
+				if (((bits >> dz) & 1u) == 0)
+					continue;
+				edited++;
+				const Chunk::BlockType childType = child.m_voxels[childIndex.x + dx][childIndex.y + dy][childIndex.z + dz];
+				if (childType != Chunk::BlockType::Air)
+				{
+					solid++;
+					solidType = childType;
+				}
+			}
+		}
+	}
+	// the rest of the footprint is still whatever generation made, which we dont know here
+	if (edited < 4)
+		return false;
+	type = (solid * 2 >= edited) ? solidType : Chunk::BlockType::Air;
+	return true;
+}
+
+void EditOverlays::GetChunkRows(const Overlay& overlay, const glm::i32vec3& offset, const ChangedBox& box, std::vector<Row>& rows) const
+{
+	// chunk index is overlay index - offset, clipped to the chunks bordered volume
+	const glm::i32vec3 minIndex = glm::max(box.min, offset - 1);
+	const glm::i32vec3 maxIndex = glm::min(box.max, offset + CHUNK_VOXEL_SIZE);
+	if (minIndex.x > maxIndex.x || minIndex.y > maxIndex.y || minIndex.z > maxIndex.z)
+		return;
+
+	for (int x = minIndex.x; x <= maxIndex.x; x++)
+	{
+		for (int y = minIndex.y; y <= maxIndex.y; y++)
+		{
+			const uint32_t mask = overlay.m_mask[x][y];
+			if (mask == 0)
+				continue;
+			int z = minIndex.z;
+			while (z <= maxIndex.z)
+			{
+				if (((mask >> z) & 1u) == 0)
+				{
+					z++;
+					continue;
+				}
+				const Chunk::BlockType type = overlay.m_voxels[x][y][z];
+				int end = z + 1;
+				while (end <= maxIndex.z && ((mask >> end) & 1u) && overlay.m_voxels[x][y][end] == type)
+					end++;
+				rows.push_back({ glm::i32vec3(x, y, z) - offset, end - z, type });
+				z = end;
+			}
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "Common.h"
+#include "Chunk.h"
+#include "glm/gtx/hash.hpp"
+
+// edited voxels, kept outside of chunks so they survive chunks getting unloaded and show up in coarser lods.
+// level 0 holds edited lod 0 voxels, level n is reduced 2x2x2 from level n - 1. a coarse voxel only gets overridden
+// once most of its footprint is edited, and prefers solid when the edited part is split.
+// overlays are keyed by chunk coord at their level, chunk pos / (CHUNK_UNIT_SIZE << level)
+class EditOverlays
+{
+public:
+	// lod 0 up to the octree root
+	static constexpr uint NUM_LEVELS = 9;
+
+	// a run of voxels along z, in the index space of some chunk. -1 and CHUNK_VOXEL_SIZE are its border
+	struct Row
+	{
+		glm::i32vec3 start;
+		int length;
+		Chunk::BlockType type;
+	};
+
+	struct KeyedRow
+	{
+		glm::i32vec3 key;
+		Row row;
+	};
+
+	// voxels a coarser chunk has to rewrite because of an Apply
+	struct LevelChange
+	{
+		uint level;
+		glm::i32vec3 key;
+		std::vector<Row> rows;
+	};
+
+	static glm::i32vec3 GetKey(const glm::vec3& chunkPos, uint level);
+	static glm::vec3 GetChunkCenter(const glm::i32vec3& key, uint level);
+
+	// writes lod 0 rows and reduces them up the levels. only levels whose voxels actually changed make it into changes.
+	// rows outside 0..CHUNK_VOXEL_SIZE - 1 are skipped, those voxels belong to the neighbor and come with its own rows
+	void Apply(const std::vector<KeyedRow>& lod0Rows, std::vector<LevelChange>& changes);
+	// writes every overridden voxel in chunks bordered volume into it. called from chunk generation
+	void WriteIntoChunk(Chunk* chunk);
+	void Clear();
+	size_t GetOverlayCount();
+
+private:
+	struct Overlay
+	{
+		Chunk::BlockType m_voxels[CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE] = { Chunk::BlockType(0) };
+		// bit z of m_mask[x][y] is set when that voxel is overridden
+		uint32_t m_mask[CHUNK_VOXEL_SIZE][CHUNK_VOXEL_SIZE] = { 0 };
+	};
+	static_assert(CHUNK_VOXEL_SIZE == 32, "overlay masks are a uint32_t per row");
+
+	// inclusive box of changed voxels in an overlay
+	struct ChangedBox
+	{
+		glm::i32vec3 min = glm::i32vec3(CHUNK_VOXEL_SIZE);
+		glm::i32vec3 max = glm::i32vec3(-1);
+		void Add(const glm::i32vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+	};
+
+	Overlay& GetOverlay(uint level, const glm::i32vec3& key);
+	bool ReduceVoxel(const Overlay& child, const glm::i32vec3& childIndex, Chunk::BlockType& type) const;
+	// rows of overridden voxels inside box of overlay key, in the index space of the chunk at key + offset
+	void GetChunkRows(const Overlay& overlay, const glm::i32vec3& offset, const ChangedBox& box, std::vector<Row>& rows) const;
+
+	std::unordered_map<glm::i32vec3, std::unique_ptr<Overlay>> m_levels[NUM_LEVELS];
+	std::mutex m_mutex;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <cstddef>
+#include <functional>
+
+// deferred deletion for objects other threads might still be holding a pointer to.
+// whoever hands a pointer to another thread Enters first, and that thread Exits once its done with it. Retire doesnt unlink anything,
+// it only holds onto the object until every Enter that could have seen it has Exited.
+// an object retired in epoch e can be freed once the epoch reaches e + 2: getting to e + 1 needed everyone from e - 1 gone,
+// getting to e + 2 needed everyone from e gone, and nobody Entering later can find it anymore
+template<typename T>
+class EpochReclaimer
+{
+public:
+	EpochReclaimer() = default;
+	EpochReclaimer(const EpochReclaimer&) = delete;
+	EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+	~EpochReclaimer() { FreeAll(); }
+
+	// what reclaiming an object means, delete unless set. owner thread only
+	void SetFreeFunction(std::function<void(T*)> free) { m_free = std::move(free); }
+
+	// any thread. returns the epoch to Exit with
+	unsigned Enter()
+	{
+		while (true)
+		{
+			const unsigned epoch = m_epoch.load();
+			m_active[epoch % 3]++;
+			// the epoch moved between loading it and counting ourselves in, our slot might already be getting reused
+			if (m_epoch.load() == epoch)
+				return epoch;
+			m_active[epoch % 3]--;
+		}
+	}
+
+	// any thread
+	void Exit(unsigned epoch)
+	{
+		m_active[epoch % 3]--;
+	}
+
+	// owner thread only, once object is unreachable for anyone Entering from now on
+	void Retire(T* object)
+	{
+		m_retired.push_back({ object, m_epoch.load() });
+	}
+
+	// owner thread only. moves the epoch on by at most one if nobody is left in the one before it,
+	// then deletes whatever nobody can be holding anymore. returns how many got deleted
+	size_t Collect()
+	{
+		const unsigned epoch = m_epoch.load();
+		if (m_active[(epoch + 2) % 3].load() == 0)
+			m_epoch.store(epoch + 1);
+
+		const unsigned current = m_epoch.load();
+		size_t freed = 0;
+		// retired in epoch order, so everything safe is at the front
+		while (!m_retired.empty() && current - m_retired.front().epoch >= 2)
+		{
+			Free(m_retired.front().object);
+			m_retired.pop_front();
+			freed++;
+		}
+		return freed;
+	}
+
+	// owner thread only, when nothing can be holding a pointer anymore. every Enter has Exited or never will, like jobs cleared out of a pool
+	void FreeAll()
+	{
+		for (const Retired& retired : m_retired)
+			Free(retired.object);
+		m_retired.clear();
+		for (std::atomic<unsigned>& active : m_active)
+			active = 0;
+	}
+
+	size_t GetRetiredCount() const { return m_retired.size(); }
+	unsigned GetEpoch() const { return m_epoch.load(); }
+
+private:
+	void Free(T* object)
+	{
+		if (m_free)
+			m_free(object);
+		else
+			delete object;
+	}
+
+	struct Retired
+	{
+		T* object;
+		unsigned epoch;
+	};
+	std::atomic<unsigned> m_epoch = 0;
+	// Entered and not yet Exited, by epoch % 3. only the current epoch and the one before it can have anyone in them
+	std::atomic<unsigned> m_active[3] = { 0, 0, 0 };
+	std::deque<Retired> m_retired;
+	std::function<void(T*)> m_free;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+// multi producer single consumer queue for workers reporting back to the main thread.
+// producers push with a single cas and never block each other, the consumer takes everything pushed so far with one exchange.
+// nodes only ever leave the list all at once, so theres no aba to worry about
+template<typename T>
+class MPSCQueue
+{
+public:
+	MPSCQueue() = default;
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+	~MPSCQueue() { Clear(); }
+
+	// any thread
+	void Push(const T& value)
+	{
+		Node* node = new Node{ value, m_head.load(std::memory_order_relaxed) };
+		while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	// consumer only. appends everything pushed so far to out in the order it was pushed, returns how many
+	size_t Drain(std::vector<T>& out)
+	{
+		Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+		const size_t begin = out.size();
+		while (node)
+		{
+			out.push_back(node->value);
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+		// the list comes out newest first
+		std::reverse(out.begin() + begin, out.end());
+		return out.size() - begin;
+	}
+
+	// consumer only
+	void Clear()
+	{
+		Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+		while (node)
+		{
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	bool Empty() const { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+private:
+	struct Node
+	{
+		T value;
+		Node* next;
+	};
+	std::atomic<Node*> m_head = nullptr;
+};
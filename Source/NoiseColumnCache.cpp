@@ -0,0 +1,58 @@
+#include "NoiseColumnCache.h"
+#include <cstring>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+bool NoiseColumnCache::Get(const glm::ivec3& key, float* height, float* dirt, float* biome)
+{
+	ZoneScoped;
+	Slot& slot = GetSlot(key);
+	std::unique_lock lock(slot.m_mutex, std::try_to_lock);
+	if (!lock.owns_lock() || !slot.m_valid || slot.m_key != key)
+	{
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	memcpy(height, slot.m_column.height, sizeof(slot.m_column.height));
+	memcpy(dirt, slot.m_column.dirt, sizeof(slot.m_column.dirt));
+	memcpy(biome, slot.m_column.biome, sizeof(slot.m_column.biome));
+	m_hits.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void NoiseColumnCache::Put(const glm::ivec3& key, const float* height, const float* dirt, const float* biome)
+{
+	ZoneScoped;
+	Slot& slot = GetSlot(key);
+	std::unique_lock lock(slot.m_mutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return;
+	memcpy(slot.m_column.height, height, sizeof(slot.m_column.height));
+	memcpy(slot.m_column.dirt, dirt, sizeof(slot.m_column.dirt));
+	memcpy(slot.m_column.biome, biome, sizeof(slot.m_column.biome));
+	slot.m_key = key;
+	slot.m_valid = true;
+}
+
+void NoiseColumnCache::Clear()
+{
+	for (Slot& slot : m_slots)
+	{
+		std::lock_guard lock(slot.m_mutex);
+		slot.m_valid = false;
+	}
+	m_hits = 0;
+	m_misses = 0;
+}
+
+NoiseColumnCache::Slot& NoiseColumnCache::GetSlot(const glm::ivec3& key)
+{
+	// neighboring columns are 32 apart in noise space so mix before taking the low bits
+	uint32_t hash = uint32_t(key.x) * 73856093u ^ uint32_t(key.y) * 19349663u ^ uint32_t(key.z) * 83492791u;
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6du;
+	hash ^= hash >> 12;
+	return m_slots[hash % NUM_SLOTS];
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "Common.h"
+
+// 2d noise grids are the same for every chunk stacked in a column at a lod, so they only need generating once per column.
+// fixed number of slots picked by hashing the column, a new column just takes over its slot.
+// slots have their own lock and nobody waits on one, a busy slot is a miss
+class NoiseColumnCache
+{
+public:
+	static constexpr uint NUM_SLOTS = 512;
+	static constexpr int GRID_SIZE = (CHUNK_VOXEL_SIZE + 2) * (CHUNK_VOXEL_SIZE + 2);
+
+	// noise2D1, noise2D2 and noise2D3 from chunk scratch memory
+	struct Column
+	{
+		float height[GRID_SIZE];
+		float dirt[GRID_SIZE];
+		float biome[GRID_SIZE];
+	};
+
+	// key is the columns noise start x/z, which also puts lods on different grids, plus the lod for the frequency
+	bool Get(const glm::ivec3& key, float* height, float* dirt, float* biome);
+	void Put(const glm::ivec3& key, const float* height, const float* dirt, const float* biome);
+	// has to be called when gen params change, with no generation running
+	void Clear();
+
+	uint64_t GetHits() const { return m_hits.load(std::memory_order_relaxed); }
+	uint64_t GetMisses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot
+	{
+		std::mutex m_mutex;
+		bool m_valid = false;
+		glm::ivec3 m_key = glm::ivec3(0);
+		Column m_column;
+	};
+
+	Slot& GetSlot(const glm::ivec3& key);
+
+	Slot m_slots[NUM_SLOTS];
+	std::atomic<uint64_t> m_hits = 0;
+	std::atomic<uint64_t> m_misses = 0;
+};
@@ -1,5 +1,6 @@
 #include "Octree.h"
 #include <stack>
+#include <algorithm>
 
 #ifdef TRACY_ENABLE
 #include <tracy/Tracy.hpp>
@@ -47,7 +48,7 @@ static int GetMaxVectorIndex(const glm::vec3& v)
 	return (v.x > v.y && v.x > v.z) ? 0 : (v.y > v.z ? 1 : 2);
 }
 
-void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newChunks, std::vector<Chunk*>& leafChunks)
+void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newChunks, std::vector<Chunk*>& leafChunks, std::vector<Chunk*>& retiredChunks)
 {
 	ZoneScoped;
 	//chunksToGenerate.reserve(128);
@@ -69,9 +70,11 @@ void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newCh
 		float maxDistance = abs(posToChunkCenter[maxIndex]);
 		if (currNode->m_lod > 0 && maxDistance < lodDist)
 		{
-			if (currNode->m_children[0] != nullptr && HasFinishedSubtree(currNode))
+			// once the children can be drawn were stale, no matter how far along we got
+			if (currNode->m_chunk != nullptr && currNode->m_children[0] != nullptr &&
+				std::all_of(std::begin(currNode->m_children), std::end(currNode->m_children), [this](const std::shared_ptr<OctreeNode>& child) { return HasFinishedSubtree(child); }))
 			{
-				delete currNode->m_chunk;
+				retiredChunks.push_back(currNode->m_chunk);
 				currNode->m_chunk = nullptr;
 			}
 			if (currNode->m_children[0] == nullptr)
@@ -94,9 +97,17 @@ void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newCh
 			if (currNode->m_chunk == nullptr)
 			{
 				glm::vec3 chunkNodeOffset = glm::vec3(-currSizeChunks * 0.5f * CHUNK_UNIT_SIZE);
-				Chunk* chunk = new Chunk(currNode->m_centerPos + chunkNodeOffset, currNode->m_lod);
+				Chunk* chunk = m_chunkPool.New(currNode->m_centerPos + chunkNodeOffset, currNode->m_lod);
 				newChunks.push_back(chunk);
 				currNode->m_chunk = chunk;
+				// collapsing a node, its children are still around to build our volume from
+				if (currNode->m_children[0] != nullptr)
+				{
+					Chunk* children[8];
+					for (uint i = 0; i < 8; i++)
+						children[i] = currNode->m_children[i]->m_chunk;
+					chunk->SetLODChildren(children);
+				}
 				if (currNode->m_lod != 0 && maxDistance > lodDist && maxDistance < lodDist * (1.0f + 1.0f / CHUNK_LOD_RADIUS))
 				{
 					chunk->SetNeedsLODSeam(BlockFace(maxIndex * 2 + (posToChunkCenter[maxIndex] >= 0 ? 0 : 1)));
@@ -104,9 +115,10 @@ void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newCh
 			}
 			if (currNode->m_children[0] != nullptr)
 			{
-				if (currNode->m_chunk->IsDeletable() && HasFinishedSubtree(currNode))
+				// same going the other way, the subtree only has to stick around until we can be drawn in its place
+				if (currNode->m_chunk->IsMeshReady())
 				{
-					ReleaseChildren(currNode);
+					ReleaseChildren(currNode, retiredChunks);
 				}
 				else
 				{
@@ -122,9 +134,14 @@ void Octree::GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newCh
 	}
 }
 
-void Octree::Clear()
+void Octree::Clear(std::vector<Chunk*>& retiredChunks)
 {
-	ReleaseChildrenBlocking(m_root);
+	if (m_root->m_chunk)
+	{
+		retiredChunks.push_back(m_root->m_chunk);
+		m_root->m_chunk = nullptr;
+	}
+	ReleaseChildren(m_root, retiredChunks);
 }
 
 Chunk* Octree::GetChunkAtWorldPos(const glm::vec3& worldPos)
@@ -139,6 +156,47 @@ Chunk* Octree::GetChunkAtWorldPos(const glm::vec3& worldPos)
 	return currNode->m_chunk;
 }
 
+Chunk* Octree::GetChunkAtWorldPos(const glm::vec3& worldPos, uint lod)
+{
+	std::shared_ptr<OctreeNode> currNode = m_root;
+	while (currNode->m_lod > lod && currNode->m_children[0] != nullptr)
+	{
+		const glm::vec3 nodeSpacePos = worldPos - currNode->m_centerPos;
+		int childIndex = GetChildIndex(nodeSpacePos);
+		currNode = currNode->m_children[childIndex];
+	}
+	return currNode->m_lod == lod ? currNode->m_chunk : nullptr;
+}
+
+// returns every chunk overlapping aabb, including parents still alive while their children finish generating
+void Octree::GetChunksInAABB(const AABB& aabb, std::vector<Chunk*>& chunks)
+{
+	std::stack<OctreeNode*> nodeStack;
+	nodeStack.push(m_root.get());
+	while (!nodeStack.empty())
+	{
+		OctreeNode* currNode = nodeStack.top();
+		nodeStack.pop();
+
+		const glm::vec3 halfExtents = glm::vec3((1 << currNode->m_lod) * 0.5f * CHUNK_UNIT_SIZE);
+		const glm::vec3 nodeMin = currNode->m_centerPos - halfExtents;
+		const glm::vec3 nodeMax = currNode->m_centerPos + halfExtents;
+		if (nodeMax.x < aabb.min.x || nodeMin.x > aabb.max.x ||
+			nodeMax.y < aabb.min.y || nodeMin.y > aabb.max.y ||
+			nodeMax.z < aabb.min.z || nodeMin.z > aabb.max.z)
+			continue;
+
+		if (currNode->m_chunk)
+			chunks.push_back(currNode->m_chunk);
+
+		if (currNode->m_children[0] != nullptr)
+		{
+			for (uint i = 0; i < 8; i++)
+				nodeStack.push(currNode->m_children[i].get());
+		}
+	}
+}
+
 int Octree::GetChildIndex(const glm::vec3& positionInNode)
 {
 	return 0 
@@ -159,70 +217,21 @@ int Octree::GetChildIndex(const glm::vec3& positionInNode)
 //	}
 //}
 
-bool Octree::ReleaseChildren(std::shared_ptr<OctreeNode> node)
+void Octree::ReleaseChildren(std::shared_ptr<OctreeNode> node, std::vector<Chunk*>& retiredChunks)
 {
 	//ZoneScoped;
 	if (node->m_children[0] == nullptr)
-	{
-		return (node->m_chunk == nullptr || node->m_chunk->IsDeletable());
-	}
-	for (uint i = 0; i < 8; i++)
-	{
-		if (!ReleaseChildren(node->m_children[i]))
-			return false;
-	}
-	bool deletable = true;
-	for (uint i = 0; i < 8; i++)
-	{
-		if (node->m_children[i]->m_chunk && !node->m_children[i]->m_chunk->IsDeletable())
-		{
-			deletable = false;
-			return false;
-		}
-	}
-	if (deletable)
-	{
-		for (uint i = 0; i < 8; i++)
-		{
-			delete node->m_children[i]->m_chunk;
-			node->m_children[i]->m_chunk = nullptr;
-			node->m_children[i] = nullptr;
-		}
-	}
-	return true;
-}
+		return;
 
-bool Octree::ReleaseChildrenBlocking(std::shared_ptr<OctreeNode> node)
-{
-	if (node->m_chunk)
-	{
-		while (!(node->m_chunk->IsDeletable() || node->m_chunk->IsBrandNew()))
-			continue;
-		delete node->m_chunk;
-		node->m_chunk = nullptr;
-	}
-	if (node->m_children[0] == nullptr)
-	{
-		return true;
-	}
 	for (uint i = 0; i < 8; i++)
 	{
-		if (!ReleaseChildrenBlocking(node->m_children[i]))
-			return false;
-		node->m_children[i] = nullptr;
+		std::shared_ptr<OctreeNode>& child = node->m_children[i];
+		if (child->m_chunk)
+			retiredChunks.push_back(child->m_chunk);
+		child->m_chunk = nullptr;
+		ReleaseChildren(child, retiredChunks);
+		child = nullptr;
 	}
-	//for (uint i = 0; i < 8; i++)
-	//{
-	//	if (node->m_children[i]->m_chunk)
-	//	{
-	//		while (!node->m_children[i]->m_chunk->IsDeletable())
-	//			continue;
-	//		delete node->m_children[i]->m_chunk;
-	//		node->m_children[i]->m_chunk = nullptr;
-	//	}
-	//	node->m_children[i] = nullptr;
-	//}
-	return true;
 }
 
 void Octree::AddChildrenToVector(std::shared_ptr<OctreeNode> node, std::vector<Chunk*>& leafChunks)
@@ -260,24 +269,15 @@ void Octree::AddChildrenToVector(std::shared_ptr<OctreeNode> node, std::vector<C
 bool Octree::HasFinishedSubtree(std::shared_ptr<OctreeNode> node)
 {
 	//ZoneScoped;
-	if (node->m_chunk && node->m_chunk->IsDeletable())
-	{
-		if (node->m_children[0] == nullptr)
-		{
-			return true;
-		}
-		else
-		{
-			for (uint i = 0; i < 8; i++)
-			{
-				if (!HasFinishedSubtree(node->m_children[i]))
-					return false;
-			}
-		}
-	}
-	else
-	{
+	if (node->m_chunk && node->m_chunk->IsMeshReady())
+		return true;
+	// a node whose chunk already went stale is covered by its children
+	if (node->m_children[0] == nullptr)
 		return false;
+	for (uint i = 0; i < 8; i++)
+	{
+		if (!HasFinishedSubtree(node->m_children[i]))
+			return false;
 	}
 	return true;
 }
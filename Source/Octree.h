@@ -4,7 +4,7 @@
 // this might not have to be here if i do it right
 #include "Chunk.h"
 
-#include "MemPooler.h"
+#include "ChunkPool.h"
 #include <memory>
 #include <glm/vec3.hpp>
 
@@ -24,24 +24,32 @@ class Octree
 {
 public:
 	Octree();
-	void GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newChunks, std::vector<Chunk*>& leafChunks);
+	// chunks that dropped out of the tree go in retiredChunks, in any state. the caller owns them now and
+	// has to keep them alive until workers are done with them
+	void GenerateFromPosition(glm::vec3 position, std::vector<Chunk*>& newChunks, std::vector<Chunk*>& leafChunks, std::vector<Chunk*>& retiredChunks);
 	void GenerateFromPosition2(glm::vec3 position, std::vector<Chunk*>& newChunks, std::vector<Chunk*>& leafChunks);
-	void Clear();
+	// parents come out before their children
+	void Clear(std::vector<Chunk*>& retiredChunks);
+	// retired chunks come back here once nothing can be holding them
+	ChunkPool& GetChunkPool() { return m_chunkPool; }
 
 	Chunk* GetChunkAtWorldPos(const glm::vec3& worldPos);
+	// the chunk of the node at lod containing worldPos, if the tree goes down that far and it has one
+	Chunk* GetChunkAtWorldPos(const glm::vec3& worldPos, uint lod);
+	void GetChunksInAABB(const AABB& aabb, std::vector<Chunk*>& chunks);
 
 private:
 	std::shared_ptr<OctreeNode> m_root = nullptr;
 	int m_size = 0;		// size in chunks
 	int m_maxDepth = 0;
 	glm::vec3 m_centerPos = glm::vec3(0);
-	//MemPooler<Chunk> m_memPool;
+	ChunkPool m_chunkPool;
 
 	static inline int GetChildIndex(const glm::vec3& positionInNode);
 
 	void CreateChildren(std::shared_ptr<OctreeNode> parent);
-	bool ReleaseChildren(std::shared_ptr<OctreeNode> node);
-	bool ReleaseChildrenBlocking(std::shared_ptr<OctreeNode> node);
+	void ReleaseChildren(std::shared_ptr<OctreeNode> node, std::vector<Chunk*>& retiredChunks);
 	void AddChildrenToVector(std::shared_ptr<OctreeNode> node, std::vector<Chunk*>& leafChunks);
+	// the node can be drawn without holes, by its own chunk or by finished children
 	bool HasFinishedSubtree(std::shared_ptr<OctreeNode> node);
 };
\ No newline at end of file
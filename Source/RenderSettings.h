@@ -19,6 +19,25 @@ public:
 	bool renderDebugWireframes = false;
 	bool deleteMesh = false;
 	bool mtEnabled = true;
+	bool caveCulling = true;
+	bool faceDirectionCulling = true;
+	// lod skirt noise goes through one GenPositionArray3D per chunk instead of GenSingle3D per sample. same output
+	bool batchSkirtNoise = true;
+	// stacked chunks reuse the 2d noise of the first chunk generated in their column. same output
+	bool cacheColumnNoise = true;
+	// a chunks noise grids run as sub-jobs on the thread pool. same output
+	bool parallelNoiseGrids = true;
+	// lod 0 chunks split their 3d noise and voxel classification into this many z slabs, and greedy mesh each axis as its own sub-job.
+	// theyre the ones the player is waiting on, far lods stay one job each. same output
+	int generationSlabs = 4;
+	bool splitMeshSweeps = true;
+	// classification hands the mesher bit rows of opaque voxels so planes with nothing in them get skipped, and quads go
+	// through per thread staging lists so a chunks mesh is allocated once at its final size. same output
+	bool fusedMeshing = true;
+	// meshes get uploaded outside of Chunk::Render, at most uploadBudgetKB a frame. visible chunks go first, then the closest.
+	// the first upload in a frame always goes so a huge mesh cant get stuck
+	bool stagedUploads = true;
+	int uploadBudgetKB = 2048;
 
 // https://stackoverflow.com/questions/1008019/c-singleton-design-pattern
 private:
@@ -11,6 +11,7 @@ in VS_OUT
 	vec2 uv;
 	vec3 normal;
 	vec4 position;
+	float ao;
 } fs_in;
 
 vec3 sunDir = { 0.1f, -1.0f, 0.2f };
@@ -45,5 +46,5 @@ void main()
 	vec3 diffuse = clamp(dot(-sunDir, fs_in.normal), 0.0f, 1.0f) * diffuseColor * (1.0f - ambientStrength);
 	vec3 ambient = ambientColor * ambientStrength;
 	vec3 camToFrag = fs_in.position.xyz - cameraPos;
-	FragColor = vec4(ApplyFog(ambient + diffuse, length(camToFrag), cameraPos, normalize(camToFrag)), 1.0f);
+	FragColor = vec4(ApplyFog((ambient + diffuse) * fs_in.ao, length(camToFrag), cameraPos, normalize(camToFrag)), 1.0f);
 } 
@@ -1,8 +1,14 @@
 #version 460 core
 #extension GL_ARB_explicit_uniform_location : enable
-layout (location = 0) in uint inData;
 
-layout (location = 0) uniform mat4 worldMat;
+// see Chunk::PackedQuad
+layout (std430, binding = 0) readonly buffer QuadBuffer
+{
+	uvec2 quads[];
+};
+
+// xyz is the chunks bottom most corner, w the world size of one of its voxels. see Chunk::Render
+layout (location = 0) uniform vec4 chunkOrigin;
 layout (location = 1) uniform mat4 viewMat;
 layout (location = 2) uniform mat4 projMat;
 
@@ -12,6 +18,7 @@ out VS_OUT
 	vec2 uv;
 	vec3 normal;
 	vec4 position;
+	float ao;
 } vs_out;
 
 vec3 colorArray[] = 
@@ -33,16 +40,52 @@ vec3 blockNormals[] = {
 	{ 0, 0, -1 },	// Back
 };
 
+// 6 vertices per quad, indexes into the corner tables below.
+// second set splits along the other diagonal so ao interpolates without the usual anisotropy
+uint quadIndices[2][6] = 
+{
+	{ 0, 3, 1, 1, 3, 2 },
+	{ 0, 3, 2, 0, 2, 1 },
+};
+
+// light per ao level, 3 is unoccluded
+float aoCurve[] = { 0.45f, 0.65f, 0.85f, 1.0f };
+
+// corners in (u, v), positive faces wind the other way round from negative ones
+vec2 quadCorners[2][4] = 
+{
+	{ { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } },
+	{ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } },
+};
+
 void main()
 {
-	//uint packedVertex = (0x3F & localVertexPos.x) | (0xFC0 & (localVertexPos.y << 6)) | (0x3F000 & (localVertexPos.z << 12)) | (0x1C0000 & (i << 18)) | (0x1FE00000 & (uint8_t(currentBlockType) << 21));
-	vec3 localPos = vec3(uint(inData & 0x3Fu), (inData & 0xFC0u) >> 6u, (inData & 0x3F000u) >> 12u);
-	uint normalIndex = (inData & 0x1C0000u) >> 18u;
-	uint blockType = (inData & 0x1FE00000u) >> 21u;
-	vs_out.position = worldMat * vec4(localPos, 1.0f);
+	uvec2 quad = quads[gl_VertexID / 6];
+
+	// 2 bits per corner, (u, v) = (0, 0), (1, 0), (0, 1), (1, 1)
+	uint ao = (quad.y >> 8u) & 0xFFu;
+	uint ao00 = ao & 3u;
+	uint ao10 = (ao >> 2u) & 3u;
+	uint ao01 = (ao >> 4u) & 3u;
+	uint ao11 = (ao >> 6u) & 3u;
+	uint corner = quadIndices[ao00 + ao11 > ao10 + ao01 ? 1 : 0][gl_VertexID % 6];
+
+	vec3 localPos = vec3(quad.x & 0x3Fu, (quad.x >> 6u) & 0x3Fu, (quad.x >> 12u) & 0x3Fu);
+	vec2 size = vec2(((quad.x >> 18u) & 0x1Fu) + 1u, ((quad.x >> 23u) & 0x1Fu) + 1u);
+	uint normalIndex = (quad.x >> 28u) & 0x7u;
+	uint blockType = quad.y & 0xFFu;
+
+	uint axis = normalIndex / 2u;
+	vec2 cornerUV = quadCorners[normalIndex % 2u][corner];
+	vec2 uv = cornerUV * size;
+	localPos[(axis + 1u) % 3u] += uv.x;
+	localPos[(axis + 2u) % 3u] += uv.y;
+
+	vs_out.position = vec4(chunkOrigin.xyz + localPos * chunkOrigin.w, 1.0f);
     gl_Position = projMat * viewMat * vs_out.position;
 	vs_out.color = colorArray[blockType];
 	vs_out.uv = vec2(0, 0);
 	// need to be transformed into worldspace, fine now since theres no rotation
 	vs_out.normal = blockNormals[normalIndex];
+	vs_out.ao = aoCurve[(ao >> (uint(cornerUV.x + cornerUV.y * 2.0f) * 2u)) & 3u];
 }
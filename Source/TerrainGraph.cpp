@@ -0,0 +1,228 @@
+#include "TerrainGraph.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+
+std::string TerrainGraph::s_path = TerrainGraph::DEFAULT_PATH;
+
+static const char* s_outputNames[Chunk::Num_NoiseOutputs] = { "height", "dirt", "biome", "density", "cave" };
+static const char* s_blockNames[] = { "Air", "Dirt", "Grass", "Stone", "Sand", "Blue" };
+
+static bool ParseBlock(const std::string& name, Chunk::BlockType& block)
+{
+	for (uint i = 0; i < sizeof(s_blockNames) / sizeof(s_blockNames[0]); i++)
+	{
+		if (name == s_blockNames[i])
+		{
+			block = Chunk::BlockType(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+// estimate of how fast a 3d node changes per unit of its input, for ClassifyVolumes margin. the node trees are encoded, so
+// theres no octave list to add up. instead the steepest gradient over a lattice of finite differences, doubled to cover peaks
+// between the samples. warps or features finer than the lattice can still be steeper, so this doesnt prove anything
+static float MeasureLipschitz(const FastNoise::SmartNode<>& generator, int seed)
+{
+	constexpr int SAMPLES = 16;
+	constexpr int COUNT = SAMPLES * SAMPLES * SAMPLES;
+	// a few features at any sane frequency, offset so samples dont land on lattice points of the noise
+	constexpr float SPACING = 8.37f;
+	constexpr float ORIGIN = -SAMPLES * SPACING * 0.5f + 0.123f;
+	constexpr float STEP = 1.0f / 256.0f;
+	constexpr float HEADROOM = 2.0f;
+
+	std::vector<float> x(COUNT), y(COUNT), z(COUNT);
+	int i = 0;
+	for (int sz = 0; sz < SAMPLES; sz++)
+	{
+		for (int sy = 0; sy < SAMPLES; sy++)
+		{
+			for (int sx = 0; sx < SAMPLES; sx++)
+			{
+				x[i] = ORIGIN + sx * SPACING;
+				y[i] = ORIGIN + sy * SPACING;
+				z[i] = ORIGIN + sz * SPACING;
+				i++;
+			}
+		}
+	}
+
+	// the value at each sample, then one step along each axis from it
+	std::vector<float> values[4] = { std::vector<float>(COUNT), std::vector<float>(COUNT), std::vector<float>(COUNT), std::vector<float>(COUNT) };
+	generator->GenPositionArray3D(values[0].data(), COUNT, x.data(), y.data(), z.data(), 0, 0, 0, seed);
+	const std::vector<float>* coords[3] = { &x, &y, &z };
+	std::vector<float> stepped(COUNT);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (i = 0; i < COUNT; i++)
+			stepped[i] = (*coords[axis])[i] + STEP;
+		const float* stepX = axis == 0 ? stepped.data() : x.data();
+		const float* stepY = axis == 1 ? stepped.data() : y.data();
+		const float* stepZ = axis == 2 ? stepped.data() : z.data();
+		generator->GenPositionArray3D(values[axis + 1].data(), COUNT, stepX, stepY, stepZ, 0, 0, 0, seed);
+	}
+
+	float steepest = 0.0f;
+	for (i = 0; i < COUNT; i++)
+	{
+		float gradientSq = 0.0f;
+		for (int axis = 1; axis < 4; axis++)
+		{
+			const float slope = (values[axis][i] - values[0][i]) / STEP;
+			gradientSq += slope * slope;
+		}
+		steepest = std::max(steepest, std::sqrt(gradientSq));
+	}
+	return steepest * HEADROOM;
+}
+
+bool TerrainGraph::Compile(const std::string& source, Chunk::ChunkNoiseGenerators& generators, std::string& error)
+{
+	Chunk::ChunkNoiseGenerators plan;
+	bool defined[Chunk::Num_NoiseOutputs] = { false };
+	std::string trees[Chunk::Num_NoiseOutputs];
+	int seed = 0;
+
+	std::istringstream lines(source);
+	std::string line;
+	int lineNumber = 0;
+	auto fail = [&](const std::string& message)
+	{
+		// whole graph problems dont have a line
+		error = lineNumber ? "line " + std::to_string(lineNumber) + ": " + message : message;
+		return false;
+	};
+
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+		std::istringstream tokens(line);
+		std::string statement;
+		if (!(tokens >> statement))
+			continue;
+
+		if (statement == "seed")
+		{
+			if (!(tokens >> seed))
+				return fail("seed needs an int");
+		}
+		else if (statement == "node")
+		{
+			std::string outputName, tree;
+			if (!(tokens >> outputName >> tree))
+				return fail("node needs an output and a node tree");
+			uint output = 0;
+			while (output < Chunk::Num_NoiseOutputs && outputName != s_outputNames[output])
+				output++;
+			if (output == Chunk::Num_NoiseOutputs)
+				return fail("unknown output " + outputName);
+			if (defined[output])
+				return fail(outputName + " already has a node");
+			defined[output] = true;
+
+			Chunk::ChunkNoiseGenerators::Step& step = plan.steps[output];
+			if (tree != "off")
+				trees[output] = tree;
+			std::string option;
+			while (tokens >> option)
+			{
+				bool parsed = false;
+				if (option == "frequency")
+					parsed = bool(tokens >> step.frequency);
+				else if (option == "seed")
+					parsed = bool(tokens >> step.seed);
+				else if (option == "maxlod")
+					parsed = bool(tokens >> step.maxLOD);
+				else if (option == "fill")
+					parsed = bool(tokens >> step.fill);
+				else
+					return fail("unknown node option " + option);
+				if (!parsed)
+					return fail(option + " is missing its value");
+			}
+		}
+		else if (statement == "biome")
+		{
+			std::string value, blockName;
+			Chunk::ChunkNoiseGenerators::BiomeBand band;
+			if (!(tokens >> value >> blockName))
+				return fail("biome needs a max value and a block");
+			// stof takes inf
+			try { band.maxValue = std::stof(value); }
+			catch (...) { return fail("bad biome value " + value); }
+			if (!ParseBlock(blockName, band.block))
+				return fail("unknown block " + blockName);
+			if (!plan.biomes.empty() && band.maxValue <= plan.biomes.back().maxValue)
+				return fail("biome bands have to go up");
+			plan.biomes.push_back(band);
+		}
+		else if (statement == "subsurface")
+		{
+			std::string blockName;
+			if (!(tokens >> blockName) || !ParseBlock(blockName, plan.subsurfaceBlock))
+				return fail("subsurface needs a block");
+		}
+		else
+		{
+			return fail("unknown statement " + statement);
+		}
+	}
+
+	lineNumber = 0;
+	for (uint output = 0; output < Chunk::Num_NoiseOutputs; output++)
+	{
+		if (!defined[output])
+			return fail(std::string("no node for ") + s_outputNames[output]);
+	}
+	if (plan.biomes.empty())
+		return fail("no biome bands");
+	// skirts and the classification pass sample it directly
+	if (trees[Chunk::Noise_Density].empty())
+		return fail("density cant be off");
+
+	// decoding a tree is the expensive part, do each one once
+	std::unordered_map<std::string, FastNoise::SmartNode<>> decoded;
+	for (uint output = 0; output < Chunk::Num_NoiseOutputs; output++)
+	{
+		Chunk::ChunkNoiseGenerators::Step& step = plan.steps[output];
+		step.seed += seed;
+		if (trees[output].empty())
+			continue;
+		FastNoise::SmartNode<>& generator = decoded[trees[output]];
+		if (!generator)
+			generator = FastNoise::NewFromEncodedNodeTree(trees[output].c_str());
+		if (!generator)
+			return fail(std::string("couldnt decode the node tree for ") + s_outputNames[output]);
+		step.generator = generator;
+		if (output == Chunk::Noise_Density || output == Chunk::Noise_Cave)
+			step.lipschitz = MeasureLipschitz(step.generator, step.seed);
+	}
+
+	generators = plan;
+	return true;
+}
+
+bool TerrainGraph::Load(const std::string& path, Chunk::ChunkNoiseGenerators& generators, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "couldnt open " + path;
+		return false;
+	}
+	std::stringstream source;
+	source << file.rdbuf();
+	if (!Compile(source.str(), generators, error))
+	{
+		error = path + " " + error;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "Chunk.h"
+
+// text description of the terrain, compiled into the flat plan GenerateVolume runs (Chunk::ChunkNoiseGenerators).
+// one statement per line, # starts a comment
+//   seed <int>                    added to every node seed
+//   node <output> <encoded node tree> [frequency <f>] [seed <int>] [maxlod <lod>] [fill <f>]
+//   node <output> off [fill <f>]  never sampled, the grid is just fill
+//   biome <max value> <block>     the first band the biome noise is under picks the surface block
+//   subsurface <block>            solid voxels with solid above them
+// outputs are height, dirt, biome, density and cave, and every one needs a node.
+// above maxlod a node is pruned and reads as fill. nodes with the same tree share a generator
+class TerrainGraph
+{
+public:
+	// relative to the build folder, like the textures
+	static constexpr const char* DEFAULT_PATH = "../Assets/Terrain/default.terrain";
+
+	// generators is only written if the whole thing compiles, otherwise error says why
+	static bool Compile(const std::string& source, Chunk::ChunkNoiseGenerators& generators, std::string& error);
+	static bool Load(const std::string& path, Chunk::ChunkNoiseGenerators& generators, std::string& error);
+
+	// the graph CreateNoiseGenerators loads. --terrain on the command line sets it
+	static void SetPath(const std::string& path) { s_path = path; }
+	static const std::string& GetPath() { return s_path; }
+
+private:
+	static std::string s_path;
+};
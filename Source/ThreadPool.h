@@ -8,6 +8,9 @@
 #include <functional>
 #include <unordered_map>
 #include <mutex>
+#include <memory>
+#include <algorithm>
+#include <condition_variable>
 
 #include "RenderSettings.h"
 
@@ -67,10 +70,14 @@ public:
 
 	~ThreadPool()
 	{
-		std::unique_lock lock(queueMutex);
-		m_done = true;
-		// this clears the queue
-		std::priority_queue<Job, std::vector<Job>, JobCmp>().swap(m_workQueue);
+		{
+			std::unique_lock lock(queueMutex);
+			m_done = true;
+			// this clears the queue
+			std::priority_queue<Job, std::vector<Job>, JobCmp>().swap(m_workQueue);
+		}
+		// idle workers are parked on the cv and have to see m_done
+		cv.notify_all();
 		for (auto& thread : m_threads)
 			thread.join();
 		delete[] m_working;
@@ -93,6 +100,49 @@ public:
 		}
 	}
 
+	// runs func(0) to func(count - 1) on the pool and returns once theyre all done. the calling thread works through them too,
+	// and only ever runs indices of this call, so its fine to call from inside a job that owns per thread state
+	void ParallelFor(unsigned count, const std::function<void(unsigned)>& func, JobPriority prio = Priority_Max)
+	{
+		if (count == 0)
+			return;
+		if (m_numThreads == 0 || count == 1)
+		{
+			for (unsigned i = 0; i < count; i++)
+				func(i);
+			return;
+		}
+
+		// helpers can get to their job after every index is taken, so they hold onto the counters
+		struct ParallelForState
+		{
+			const std::function<void(unsigned)>* func;
+			unsigned count;
+			std::atomic<unsigned> next = 0;
+			std::atomic<unsigned> finished = 0;
+		};
+		auto state = std::make_shared<ParallelForState>();
+		state->func = &func;
+		state->count = count;
+		auto work = [state]()
+		{
+			unsigned i;
+			// func only gets touched while theres an index left, which keeps the caller waiting
+			while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) < state->count)
+			{
+				(*state->func)(i);
+				state->finished.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		const unsigned helpers = std::min(count - 1, unsigned(m_numThreads));
+		for (unsigned i = 0; i < helpers; i++)
+			Submit(work, prio);
+		work();
+		while (state->finished.load(std::memory_order_acquire) < count)
+			std::this_thread::yield();
+	}
+
 	//void Submit(std::function<void()> t, JobPriority prio)
 	//{
 	//	m_workQueue.push({ jobCount++, t, prio });
@@ -183,7 +233,7 @@ private:
 			{
 				queueMutex.unlock();
 				std::unique_lock lock(cvMutex);
-				cv.wait(lock, [&] {return m_workQueue.size() > 0; });
+				cv.wait(lock, [&] {return m_done || m_workQueue.size() > 0; });
 			}
 		}
 		return;
@@ -0,0 +1,79 @@
+#include "VoxelCollision.h"
+
+#include <bit>
+#include <glm/common.hpp>
+
+float VoxelCollision::SweepAxis(const AABB& box, int axis, float delta, bool& hit) const
+{
+	hit = false;
+	const glm::vec3 boxMin = box.min * float(UNIT_VOXEL_RESOLUTION);
+	const glm::vec3 boxMax = box.max * float(UNIT_VOXEL_RESOLUTION);
+	const float voxelDelta = delta * UNIT_VOXEL_RESOLUTION;
+
+	// voxels the box actually overlaps on the other two axes, just touching a face doesnt count
+	const glm::i32vec3 lo = glm::i32vec3(glm::floor(boxMin));
+	const glm::i32vec3 hi = glm::i32vec3(glm::ceil(boxMax)) - 1;
+
+	// planes entirely ahead of the box that it reaches this sweep, nearest first
+	const bool positive = voxelDelta > 0.0f;
+	const float face = positive ? boxMax[axis] : boxMin[axis];
+	const int first = positive ? int(std::ceil(face)) : int(std::floor(face)) - 1;
+	const int last = positive ? int(std::ceil(face + voxelDelta)) - 1 : int(std::floor(face + voxelDelta));
+	if (positive ? first > last : first < last)
+		return delta;
+
+	int hitPlane = 0;
+	if (axis == 2)
+	{
+		// every row in the cross section at once
+		uint64_t solid = 0;
+		for (int x = lo.x; x <= hi.x; x++)
+		{
+			for (int y = lo.y; y <= hi.y; y++)
+				solid |= m_rows[x - m_min.x][y - m_min.y];
+		}
+		solid &= positive ? BitRange(first - m_min.z, last - m_min.z) : BitRange(last - m_min.z, first - m_min.z);
+		if (solid == 0)
+			return delta;
+		hitPlane = m_min.z + (positive ? std::countr_zero(solid) : 63 - std::countl_zero(solid));
+	}
+	else
+	{
+		const int step = positive ? 1 : -1;
+		for (hitPlane = first; hitPlane != last + step; hitPlane += step)
+		{
+			if (PlaneHasVoxels(axis, hitPlane, lo, hi))
+				break;
+		}
+		if (hitPlane == last + step)
+			return delta;
+	}
+
+	hit = true;
+	// up to the face of the voxel we hit, never backwards if were already sitting against it
+	if (positive)
+		return glm::max((float(hitPlane) - face) / UNIT_VOXEL_RESOLUTION - SKIN, 0.0f);
+	return glm::min((float(hitPlane + 1) - face) / UNIT_VOXEL_RESOLUTION + SKIN, 0.0f);
+}
+
+bool VoxelCollision::PlaneHasVoxels(int axis, int k, const glm::i32vec3& lo, const glm::i32vec3& hi) const
+{
+	const uint64_t zMask = BitRange(lo.z - m_min.z, hi.z - m_min.z);
+	if (axis == 0)
+	{
+		const uint64_t* plane = m_rows[k - m_min.x];
+		for (int y = lo.y; y <= hi.y; y++)
+		{
+			if (plane[y - m_min.y] & zMask)
+				return true;
+		}
+		return false;
+	}
+
+	for (int x = lo.x; x <= hi.x; x++)
+	{
+		if (m_rows[x - m_min.x][k - m_min.y] & zMask)
+			return true;
+	}
+	return false;
+}
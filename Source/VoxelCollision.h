@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#include "Common.h"
+#include "Chunk.h"
+
+// swept box vs lod 0 voxels, one axis after another. the voxels around a sweep get copied out of their chunks once,
+// as rows of collideable bits along z, with one chunk lookup per chunk instead of per voxel. each axis then tests whole
+// planes of the boxes cross section at a time, or for z ors the rows together and bit scans for the first solid one.
+// fixed size and nothing gets allocated, so its cheap enough to run for lots of colliders a frame
+class VoxelCollision
+{
+public:
+	// voxels per axis one gather can hold. sweeps that would need more get split into substeps
+	static constexpr int MAX_VOXELS = 64;
+	// how far short of a voxel a stopped box ends up, so the next sweep doesnt start out touching it
+	static constexpr float SKIN = 0.001f;
+
+	// moves box by delta along x, then y, then z, each axis stopping short of the first collideable voxel in its way.
+	// voxels the box already overlaps dont stop it, so it can always get out of them.
+	// getChunk(chunkCoord) returns the lod 0 chunk at chunkCoord * CHUNK_UNIT_SIZE if its volume is done, otherwise nullptr.
+	// returns false if it runs into voxels that arent loaded yet, with moved as far as it got before them
+	template<typename GetChunk>
+	bool Sweep(const AABB& box, const glm::vec3& delta, const GetChunk& getChunk, glm::vec3& moved, bool hit[3]);
+
+private:
+	// fills m_rows with voxels min to max inclusive, in voxel coords
+	template<typename GetChunk>
+	bool Gather(const glm::i32vec3& min, const glm::i32vec3& max, const GetChunk& getChunk);
+	// how far box gets along axis towards delta, from the rows in the last Gather
+	float SweepAxis(const AABB& box, int axis, float delta, bool& hit) const;
+	// whether voxel plane k along axis has anything collideable in the voxel ranges lo to hi of the other two axes
+	bool PlaneHasVoxels(int axis, int k, const glm::i32vec3& lo, const glm::i32vec3& hi) const;
+	static int FloorDiv(int a, int b) { return (a >= 0 ? a : a - b + 1) / b; }
+	// bits lo to hi inclusive, both in 0 to 63
+	static uint64_t BitRange(int lo, int hi) { return (~uint64_t(0) >> (63 - (hi - lo))) << lo; }
+
+	// voxel coords of bit 0 of m_rows[0][0]
+	glm::i32vec3 m_min = glm::i32vec3(0);
+	glm::i32vec3 m_size = glm::i32vec3(0);
+	// bit z of [x][y] is set when that voxel is collideable
+	uint64_t m_rows[MAX_VOXELS][MAX_VOXELS];
+};
+
+template<typename GetChunk>
+bool VoxelCollision::Sweep(const AABB& box, const glm::vec3& delta, const GetChunk& getChunk, glm::vec3& moved, bool hit[3])
+{
+	moved = glm::vec3(0);
+	hit[0] = hit[1] = hit[2] = false;
+
+	// one gather has to fit the box plus however far it goes in a step, with a voxel of slack either side
+	const glm::vec3 boxVoxels = (box.max - box.min) * float(UNIT_VOXEL_RESOLUTION);
+	int steps = 1;
+	for (int a = 0; a < 3; a++)
+	{
+		const float room = float(MAX_VOXELS - 3) - boxVoxels[a];
+		if (room <= 0.0f)
+			return false;
+		steps = glm::max(steps, int(std::ceil(glm::abs(delta[a]) * UNIT_VOXEL_RESOLUTION / room)));
+	}
+
+	glm::vec3 stepDelta = delta / float(steps);
+	AABB current = box;
+	for (int step = 0; step < steps; step++)
+	{
+		const glm::vec3 sweptMin = glm::min(current.min, current.min + stepDelta) * float(UNIT_VOXEL_RESOLUTION);
+		const glm::vec3 sweptMax = glm::max(current.max, current.max + stepDelta) * float(UNIT_VOXEL_RESOLUTION);
+		if (!Gather(glm::i32vec3(glm::floor(sweptMin)) - 1, glm::i32vec3(glm::floor(sweptMax)) + 1, getChunk))
+			return false;
+
+		for (int a = 0; a < 3; a++)
+		{
+			if (stepDelta[a] == 0.0f)
+				continue;
+			bool axisHit = false;
+			const float distance = SweepAxis(current, a, stepDelta[a], axisHit);
+			current.min[a] += distance;
+			current.max[a] += distance;
+			moved[a] += distance;
+			if (axisHit)
+			{
+				hit[a] = true;
+				// the rest of the steps would only run into it again
+				stepDelta[a] = 0.0f;
+			}
+		}
+	}
+	return true;
+}
+
+template<typename GetChunk>
+bool VoxelCollision::Gather(const glm::i32vec3& min, const glm::i32vec3& max, const GetChunk& getChunk)
+{
+	m_min = min;
+	m_size = max - min + 1;
+	for (int x = 0; x < m_size.x; x++)
+	{
+		for (int y = 0; y < m_size.y; y++)
+			m_rows[x][y] = 0;
+	}
+
+	const glm::i32vec3 chunkMin(FloorDiv(min.x, CHUNK_VOXEL_SIZE), FloorDiv(min.y, CHUNK_VOXEL_SIZE), FloorDiv(min.z, CHUNK_VOXEL_SIZE));
+	const glm::i32vec3 chunkMax(FloorDiv(max.x, CHUNK_VOXEL_SIZE), FloorDiv(max.y, CHUNK_VOXEL_SIZE), FloorDiv(max.z, CHUNK_VOXEL_SIZE));
+	for (int cx = chunkMin.x; cx <= chunkMax.x; cx++)
+	{
+		for (int cy = chunkMin.y; cy <= chunkMax.y; cy++)
+		{
+			for (int cz = chunkMin.z; cz <= chunkMax.z; cz++)
+			{
+				const glm::i32vec3 chunkCoord(cx, cy, cz);
+				const Chunk* chunk = getChunk(chunkCoord);
+				if (chunk == nullptr)
+					return false;
+				if (chunk->IsEmpty())
+					continue;
+
+				// the part of the gather inside this chunk, in chunk voxel indices
+				const glm::i32vec3 chunkVoxel = chunkCoord * CHUNK_VOXEL_SIZE;
+				const glm::i32vec3 lo = glm::max(min - chunkVoxel, glm::i32vec3(0));
+				const glm::i32vec3 hi = glm::min(max - chunkVoxel, glm::i32vec3(CHUNK_VOXEL_SIZE - 1));
+				const uint32_t zMask = uint32_t((uint64_t(1) << (hi.z + 1)) - 1) & ~uint32_t((uint64_t(1) << lo.z) - 1);
+				const int zShift = chunkVoxel.z - m_min.z;
+				for (int x = lo.x; x <= hi.x; x++)
+				{
+					for (int y = lo.y; y <= hi.y; y++)
+					{
+						const uint64_t row = chunk->GetCollisionRow(x, y) & zMask;
+						if (row == 0)
+							continue;
+						m_rows[chunkVoxel.x + x - m_min.x][chunkVoxel.y + y - m_min.y] |= zShift >= 0 ? row << zShift : row >> -zShift;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
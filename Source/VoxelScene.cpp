@@ -7,6 +7,10 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/norm.hpp>
 #include "Camera.h"
+#include "NoiseColumnCache.h"
+#include "TerrainGraph.h"
+#include <cstdlib>
+#include <algorithm>
 #include <math.h>
 
 #ifdef DEBUG
@@ -43,9 +47,8 @@ VoxelScene::VoxelScene()
 	//m_noiseGenerator->SetGain(0.1f);
 	//m_noiseGenerator->SetLacunarity(10);
 	//m_noiseGenerator->SetOctaveCount(3);
-	m_noiseGenerators.noiseGenerator = FastNoise::NewFromEncodedNodeTree("EQADAAAAAAAAQBAAAAAAPxkADQADAAAAAAAAQAkAAAAAAD8AAAAAAAEEAAAAAABI4TpAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAgD8AAAAAPwAAAAAA");
-	m_noiseGenerators.noiseGeneratorCave = FastNoise::NewFromEncodedNodeTree("DQACAAAAAAAAQBoAAJqZGb8BGwAPAAIAAAAAAABADQACAAAAAAAAQAkAAAAAAD8AAAAAAAAAAAA/AAAAAAAAAACAvwAAAAA/AAAAAAA=");
-	m_noiseGenerators.biomeGenerator = FastNoise::NewFromEncodedNodeTree("CgADAAAAAAAAAAAAAIA/");
+	CreateNoiseGenerators(m_noiseGenerators);
+	m_chunkReclaimer.SetFreeFunction([this](Chunk* chunk) { m_octree.GetChunkPool().Free(chunk); });
 	//auto fnSimplex2 = FastNoise::New<FastNoise::Simplex>();
 	//m_noiseGeneratorCave->SetSource(fnSimplex2);
 	//m_noiseGeneratorCave->SetOctaveCount(2);
@@ -55,30 +58,18 @@ VoxelScene::VoxelScene()
 		m_threadPool.GetThreadIDs(),
 		std::bind(&VoxelScene::AddToMeshListCallback, this, std::placeholders::_1),
 		std::bind(&VoxelScene::AddToRenderListCallback, this, std::placeholders::_1),
-		&m_chunkGenParams
+		&m_chunkGenParams,
+		std::bind(&EditOverlays::WriteIntoChunk, &m_editOverlays, std::placeholders::_1),
+		[this](uint count, const std::function<void(uint)>& func) { m_threadPool.ParallelFor(count, func); }
 	);
 
+	// chunk quads are pulled from a storage buffer in the vertex shader so this has no attributes,
+	// but core profile still wants something bound to draw with
 	glGenVertexArrays(1, &m_chunkVAO);
-	//during initialization
-	glBindVertexArray(m_chunkVAO);
 
 	//https://riptutorial.com/opengl/example/28662/version-4-3
 	constexpr int vertexBindingPoint = 0;// free to choose, must be less than the GL_MAX_VERTEX_ATTRIB_BINDINGS limit
 
-	glVertexAttribIFormat(0, 1, GL_UNSIGNED_INT, 0);
-	// set the details of a single attribute
-	glVertexAttribBinding(0, vertexBindingPoint);
-	// which buffer binding point it is attached to
-	glEnableVertexAttribArray(0);
-
-	//glVertexAttribFormat(1, 3, GL_FLOAT, false, offsetof(VertexPCN, color));
-	//glVertexAttribBinding(1, vertexBindingPoint);
-	//glEnableVertexAttribArray(1);
-
-	//glVertexAttribFormat(2, 3, GL_FLOAT, false, offsetof(VertexPCN, normal));
-	//glVertexAttribBinding(2, vertexBindingPoint);
-	//glEnableVertexAttribArray(2);
-
 	glGenBuffers(1, &m_aabbVBO);
 	glGenBuffers(1, &m_aabbEBO);
 
@@ -116,6 +107,11 @@ VoxelScene::~VoxelScene()
 
 	for (auto& chunk : m_chunks)
 		delete chunk.second;
+	m_octree.Clear(m_retiredChunks);
+	for (Chunk* chunk : m_retiredChunks)
+		m_chunkReclaimer.Retire(chunk);
+	m_chunkReclaimer.FreeAll();
+	m_octree.GetChunkPool().Clear();
 
 	Chunk::DeleteShared();
 }
@@ -126,6 +122,17 @@ void VoxelScene::InitShared()
 	s_debugWireframeShaderProgram = ShaderProgram("DebugWireframe.vs.glsl", "DebugWireframe.fs.glsl");
 }
 
+void VoxelScene::CreateNoiseGenerators(Chunk::ChunkNoiseGenerators& generators)
+{
+	std::string error;
+	if (!TerrainGraph::Load(TerrainGraph::GetPath(), generators, error))
+	{
+		// nothing can generate without a plan
+		std::cout << "ERROR::TERRAIN::" << error << std::endl;
+		std::exit(-1);
+	}
+}
+
 Chunk* VoxelScene::CreateChunk(const glm::i32vec3& chunkPos)
 {
 	if (m_chunks[chunkPos])
@@ -144,7 +151,6 @@ inline void VoxelScene::NotifyNeighbor(Chunk* chunk, glm::i32vec3 pos, BlockFace
 	{
 		// this might be too slow to wait for locks
 		neighbor->UpdateNeighborRef(oppositeSide, chunk);
-		chunk->UpdateNeighborRefNewChunk(side, neighbor);
 	}
 }
 
@@ -161,10 +167,45 @@ void VoxelScene::Update(const glm::vec3& position)
 	}
 	m_frameChunks.clear();
 	std::vector<Chunk*> newChunks;
-	m_octree.GenerateFromPosition(position, newChunks, m_frameChunks);
+	m_octree.GenerateFromPosition(position, newChunks, m_frameChunks, m_retiredChunks);
 	for (Chunk* chunk : newChunks)
 	{
-		m_threadPool.Submit(std::bind(&Chunk::GenerateVolume, chunk, &m_noiseGenerators), chunk->GetLOD() == 0 ? Priority_High : Priority_Med);
+		// pinned from here, the chunk can get retired while the job is still queued
+		const unsigned epoch = m_chunkReclaimer.Enter();
+		m_threadPool.Submit([this, chunk, epoch]()
+			{
+				if (!chunk->IsRetired())
+					chunk->GenerateVolume(&m_noiseGenerators);
+				else
+					// generation would have let go of them, the children shouldnt stay pinned until we get reclaimed
+					chunk->ReleaseLODChildren();
+				m_chunkReclaimer.Exit(epoch);
+			}, chunk->GetLOD() == 0 ? Priority_High : Priority_Med);
+	}
+	RetireChunks(m_retiredChunks);
+
+	ProcessEdits();
+
+	// only the grid path meshes off of neighbor notifications
+	m_drainedCompletions.clear();
+	m_meshCompletions.Drain(m_drainedCompletions);
+	if (!m_useOctree)
+		m_generateMeshList.insert(m_generateMeshList.end(), m_drainedCompletions.begin(), m_drainedCompletions.end());
+
+	m_chunkReclaimer.Collect();
+
+	const auto now = std::chrono::high_resolution_clock::now();
+	const double seconds = std::chrono::duration<double>(now - m_lastPoolStatsTime).count();
+	if (seconds >= 1.0)
+	{
+		const ChunkPool::Stats& poolStats = m_octree.GetChunkPool().GetStats();
+		const uint64_t bufferCreations = Chunk::GetBufferCreations();
+		s_imguiData.chunkAllocationsPerSec = (poolStats.allocations - m_lastPoolStats.allocations) / seconds;
+		s_imguiData.chunkReusesPerSec = (poolStats.reuses - m_lastPoolStats.reuses) / seconds;
+		s_imguiData.bufferCreationsPerSec = (bufferCreations - m_lastBufferCreations) / seconds;
+		m_lastPoolStats = poolStats;
+		m_lastBufferCreations = bufferCreations;
+		m_lastPoolStatsTime = now;
 	}
 
 	if (!RenderSettings::Get().mtEnabled)
@@ -184,21 +225,66 @@ void VoxelScene::ResetVoxelScene()
 {
 	m_threadPool.ClearJobPool();
 	m_threadPool.WaitForAllThreadsFinished();
+	// edit jobs either finished or just got cleared out of the pool, let the octree delete their chunks
+	for (auto& [chunk, edits] : m_pendingEdits)
+		chunk->SetEditsPending(false);
+	for (Chunk* chunk : m_editRemeshChunks)
+		chunk->SetEditsPending(false);
+	m_pendingEdits.clear();
+	m_editRemeshChunks.clear();
+	// their epochs go with everything else in FreeAll below
+	m_editRemeshedCompletions.Clear();
+	// edits are relative to the terrain they were made on, they dont carry over to new gen params
+	m_editOverlays.Clear();
+	m_editOverlayRows.clear();
+	m_editOverlayChanges.clear();
+	m_editOverlayJobInFlight = false;
+	m_editOverlayJobDone = false;
+	Chunk::GetNoiseColumnCache().Clear();
+
 	for (auto& chunk : m_chunks)
 		delete chunk.second;
 	m_chunks.clear();
 
 	m_generateMeshList.clear();
-	m_generateMeshCallbackList.clear();
+	m_meshCompletions.Clear();
 	m_renderList.clear();
-	m_renderCallbackList.clear();
+	m_renderCompletions.Clear();
 
 	m_currentGenerateRadius = 3;
 	m_lastGenerateRadius = 0;
 	m_lastGeneratePos = glm::vec3(0, 0, 0);
 	m_lastGeneratedChunkPos = glm::i32vec3(UINT_MAX, UINT_MAX, UINT_MAX);
 
-	m_octree.Clear();
+	// nothing is running anymore, jobs that got cleared never Exited but theyll never touch their chunks either
+	m_octree.Clear(m_retiredChunks);
+	RetireChunks(m_retiredChunks);
+	m_chunkReclaimer.FreeAll();
+}
+
+void VoxelScene::RetireChunks(std::vector<Chunk*>& chunks)
+{
+	ZoneScoped;
+	for (Chunk* chunk : chunks)
+	{
+		chunk->SetRetired();
+		auto it = m_pendingEdits.find(chunk);
+		if (it != m_pendingEdits.end())
+		{
+			// lod 0 edits only reach the overlays once theyre applied, dont lose them with the chunk.
+			// coarser edits came out of the overlays to begin with
+			if (chunk->GetLOD() == 0)
+			{
+				const glm::i32vec3 overlayKey = EditOverlays::GetKey(chunk->GetChunkPos(), 0);
+				for (const VoxelEdit& edit : it->second)
+					m_editOverlayRows.push_back({ overlayKey, { edit.index, edit.length, edit.type } });
+			}
+			m_pendingEdits.erase(it);
+		}
+		m_editRemeshChunks.erase(chunk);
+		m_chunkReclaimer.Retire(chunk);
+	}
+	chunks.clear();
 }
 
 void VoxelScene::Render(const Camera* camera, const Camera* debugCullCamera)
@@ -211,51 +297,170 @@ void VoxelScene::Render(const Camera* camera, const Camera* debugCullCamera)
 
 	RenderSettings::DrawMode drawMode = RenderSettings::Get().m_drawMode;
 
+	// the octree hands us the chunks to draw, but the queue still has to be emptied
+	m_drainedCompletions.clear();
+	m_renderCompletions.Drain(m_useOctree ? m_drainedCompletions : m_renderList);
 	if (!m_useOctree)
 	{
-		m_renderCallbackListMutex.lock();
-		if (m_renderCallbackList.size())
-			m_renderList.insert(m_renderList.end(), m_renderCallbackList.begin(), m_renderCallbackList.end());
-		m_renderCallbackList.clear();
-		m_renderCallbackListMutex.unlock();
-
 		// throw this on a thread? should only sort culled chunks or just not sort at all.
 		glm::vec3 chunkPos = m_lastGeneratedChunkPos;
-		m_renderList.sort([chunkPos](const Chunk* a, const Chunk* b)
+		std::sort(m_renderList.begin(), m_renderList.end(), [chunkPos](const Chunk* a, const Chunk* b)
 			{ return glm::length2(chunkPos - a->m_chunkPos) < glm::length2(chunkPos - b->m_chunkPos); }
 		);
 	}
 
 	
-	uint vertexCount = 0;
+	uint quadCount = 0;
 	uint numRenderChunks = 0;
 	double totalGenTime = 0;
 
 	ZoneNamed(Render, true);
 
-	glm::mat4 modelMat;
 	glBindVertexArray(m_chunkVAO);
 	glDepthMask(GL_TRUE);
-	
-	for (Chunk* chunk : m_frameChunks)
+
+	const bool caveCulling = RenderSettings::Get().caveCulling;
+	if (caveCulling)
+		TraverseVisibility(debugCullCamera);
+	if (RenderSettings::Get().stagedUploads)
+		UploadMeshes(camera->GetPosition(), debugCullCamera->GetFrustum(), caveCulling);
+
+	for (Chunk* chunk : (caveCulling ? m_visibleChunks : m_frameChunks))
 	{
 		if (chunk == nullptr || !chunk->Renderable())
 			continue;
 
 		if (chunk->IsInFrustum(debugCullCamera->GetFrustum()))
 		{
-			vertexCount += chunk->GetVertexCount();
 			totalGenTime += chunk->m_genTime;
 			numRenderChunks++;
-			chunk->Render(drawMode);
+			quadCount += chunk->Render(drawMode, camera->GetPosition());
 		}
 	}
 	s_imguiData.numTotalChunks = m_frameChunks.size();
 	s_imguiData.numRenderChunks = numRenderChunks;
-	s_imguiData.numVerts = vertexCount;
+	s_imguiData.numVisibleChunks = caveCulling ? uint(m_visibleChunks.size()) : uint(m_frameChunks.size());
+	s_imguiData.numQuads = quadCount;
 	s_imguiData.avgChunkGenTime = totalGenTime / s_imguiData.numRenderChunks;
 }
 
+void VoxelScene::UploadMeshes(const glm::vec3& cameraPos, const Frustum& frustum, bool caveCulling)
+{
+	ZoneScoped;
+	// a burst of chunks finishing together used to all upload the first frame they got drawn
+	m_uploadQueue.clear();
+	for (Chunk* chunk : m_frameChunks)
+	{
+		if (chunk == nullptr || !chunk->NeedsUpload())
+			continue;
+		const bool visible = (!caveCulling || chunk->m_visibilityFrame == m_visibilityFrame) && chunk->IsInFrustum(frustum);
+		const AABB& bounds = chunk->GetBoundingBox();
+		m_uploadQueue.push_back({ chunk, !visible, glm::length2((bounds.min + bounds.max) * 0.5f - cameraPos) });
+	}
+	std::sort(m_uploadQueue.begin(), m_uploadQueue.end(), [](const PendingUpload& a, const PendingUpload& b)
+		{ return a.hidden != b.hidden ? b.hidden : a.distance2 < b.distance2; }
+	);
+
+	const uint64_t budget = uint64_t(std::max(RenderSettings::Get().uploadBudgetKB, 0)) * 1024;
+	const auto now = std::chrono::high_resolution_clock::now();
+	uint numUploads = 0;
+	uint64_t uploadedBytes = 0;
+	uint64_t queuedBytes = 0;
+	double totalLatencyMs = 0;
+	double maxLatencyMs = 0;
+	bool budgetSpent = false;
+	for (const PendingUpload& upload : m_uploadQueue)
+	{
+		const uint bytes = upload.chunk->GetUploadBytes();
+		// strictly in priority order, once something doesnt fit everything after it waits too
+		budgetSpent = budgetSpent || (numUploads > 0 && uploadedBytes + bytes > budget);
+		if (budgetSpent)
+		{
+			queuedBytes += bytes;
+			continue;
+		}
+		std::chrono::duration<double, std::milli> latency = now - upload.chunk->GetMeshCompleteTime();
+		upload.chunk->UploadMesh();
+		numUploads++;
+		uploadedBytes += bytes;
+		totalLatencyMs += latency.count();
+		maxLatencyMs = std::max(maxLatencyMs, latency.count());
+	}
+
+	s_imguiData.numUploads = numUploads;
+	s_imguiData.uploadedBytes = uploadedBytes;
+	s_imguiData.numQueuedUploads = uint(m_uploadQueue.size()) - numUploads;
+	s_imguiData.queuedUploadBytes = queuedBytes;
+	s_imguiData.avgUploadLatencyMs = numUploads ? totalLatencyMs / numUploads : 0.0;
+	s_imguiData.maxUploadLatencyMs = maxLatencyMs;
+}
+
+// breadth first walk out from the camera's chunk, only stepping into neighbors we can see through connected faces
+// https://tomcc.github.io/2014/08/31/visibility-2.html
+void VoxelScene::TraverseVisibility(const Camera* camera)
+{
+	ZoneScoped;
+	m_visibilityFrame++;
+	m_visibleChunks.clear();
+	m_visibilityQueue.clear();
+
+	Chunk* startChunk = m_octree.GetChunkAtWorldPos(camera->GetPosition());
+	if (startChunk == nullptr)
+	{
+		m_visibleChunks = m_frameChunks;
+		return;
+	}
+
+	const Frustum& frustum = camera->GetFrustum();
+	auto visit = [&](Chunk* chunk, int entryFace, uint8_t travelledMask)
+	{
+		// a chunk can be entered through each of its faces once. bit 6 is the camera's own chunk
+		const uint8_t entryBit = entryFace < 0 ? 1u << BlockFace::NumFaces : 1u << entryFace;
+		if (chunk->m_visibilityFrame != m_visibilityFrame)
+		{
+			chunk->m_visibilityFrame = m_visibilityFrame;
+			chunk->m_visibilityEntryMask = 0;
+			m_visibleChunks.push_back(chunk);
+		}
+		else if (chunk->m_visibilityEntryMask & entryBit)
+		{
+			return;
+		}
+		chunk->m_visibilityEntryMask |= entryBit;
+		m_visibilityQueue.push_back({ chunk, int8_t(entryFace), travelledMask });
+	};
+
+	visit(startChunk, -1, 0);
+	for (size_t head = 0; head < m_visibilityQueue.size(); head++)
+	{
+		const VisibilityNode node = m_visibilityQueue[head];
+		const AABB& bounds = node.chunk->GetBoundingBox();
+		for (uint face = 0; face < BlockFace::NumFaces; face++)
+		{
+			if (node.travelledMask & (1u << s_opposingBlockFaces[face]))
+				continue;
+			if (node.entryFace >= 0 && !node.chunk->FacesConnected(BlockFace(node.entryFace), BlockFace(face)))
+				continue;
+
+			// thin slab just outside this face, pulled in from the edges so we dont pick up diagonal neighbors
+			constexpr float epsilon = 0.01f;
+			const int axis = face / 2;
+			glm::vec3 slabMin = bounds.min + glm::vec3(epsilon);
+			glm::vec3 slabMax = bounds.max - glm::vec3(epsilon);
+			slabMin[axis] = slabMax[axis] = (face % 2 == 0) ? bounds.max[axis] + epsilon : bounds.min[axis] - epsilon;
+
+			m_visibilityNeighbors.clear();
+			m_octree.GetChunksInAABB(AABB(slabMin, slabMax), m_visibilityNeighbors);
+			for (Chunk* neighbor : m_visibilityNeighbors)
+			{
+				if (neighbor == node.chunk || !neighbor->IsInFrustum(frustum))
+					continue;
+				visit(neighbor, s_opposingBlockFaces[face], uint8_t(node.travelledMask | (1u << face)));
+			}
+		}
+	}
+}
+
 void VoxelScene::RenderTransparency(const Camera* camera, const Camera* debugCullCamera)
 {
 	if (RenderSettings::Get().renderDebugWireframes)
@@ -320,55 +525,6 @@ static int IntersectMovingAABBAABB(
 	return 1;
 }
 
-// Intersect AABBs a and b moving with constant velocities va and vb.
-// On intersection, return time of first and last contact in tfirst and tlast
-static int IntersectMovingAABBAABBAxis(
-	const AABB& a,
-	const AABB& b,
-	const glm::vec3& va,
-	const glm::vec3& vb,
-	uint8_t slideMaskB,
-	float& tfirst,
-	float& tlast,
-	int& i
-)
-{
-	// Exit early if a and b initially overlapping
-	if (TestAABBAABB(a, b)) {
-		tfirst = tlast = 0.0f;
-		fprintf(stderr, "overlapping\n");
-		return 1;
-	}
-
-	// Use relative velocity; effectively treating a as stationary
-	glm::vec3 v = vb - va;
-
-	// Initialize times of first and last contact
-	tfirst = 0.0f;
-	tlast = 1.0f;
-	int i2 = (i + 1) % 3;
-	int i3 = (i + 2) % 3;
-
-	// this isnt fully correct. this is just checking initial positions. need to also cast this movement?
-	if (a.max[i2] < b.min[i2] || a.min[i2] > b.max[i2]) return 0;
-	if (a.max[i3] < b.min[i3] || a.min[i3] > b.max[i3]) return 0;
-
-	// For each axis, determine times of first and last contact, if any
-	if (v[i] < 0.0f) {
-		if (b.max[i] < a.min[i]) return 0; // Nonintersecting and moving apart
-		if (a.max[i] < b.min[i]) tfirst = glm::max((a.max[i] - b.min[i]) / v[i], tfirst);
-		if (b.max[i] > a.min[i]) tlast = glm::min((a.min[i] - b.max[i]) / v[i], tlast);
-	}
-	if (v[i] > 0.0f) {
-		if (b.min[i] > a.max[i]) return 0; // Nonintersecting and moving apart
-		if (b.max[i] < a.min[i]) tfirst = glm::max((a.min[i] - b.max[i]) / v[i], tfirst);
-		if (a.max[i] > b.min[i]) tlast = glm::min((a.max[i] - b.min[i]) / v[i], tlast);
-	}
-	// No overlap possible if time of first contact occurs after time of last contact
-	if (tfirst > tlast) return 0;
-	return 1;
-}
-
 void VoxelScene::ResolveBoxCollider(BoxCollider& collider, float timeDelta)
 {
 	const AABB& aabb = collider.GetAABB();
@@ -434,7 +590,7 @@ void VoxelScene::ResolveBoxCollider(BoxCollider& collider, float timeDelta)
 				currentPos = combinedAABB.min + offset * VOXEL_UNIT_SIZE;
 				// need to solve edge case if outside the octree
 				Chunk* currChunk = m_octree.GetChunkAtWorldPos(currentPos);
-				if (currChunk == nullptr || !currChunk->IsDeletable() || currChunk->GetLOD() != 0)
+				if (currChunk == nullptr || !currChunk->IsMeshReady() || currChunk->GetLOD() != 0)
 					return;
 
 				localBlocks[index++] = currChunk->VoxelIsCollideableAtWorldPos(currentPos);
@@ -492,138 +648,47 @@ void VoxelScene::ResolveBoxCollider(BoxCollider& collider, float timeDelta)
 
 void VoxelScene::ResolveBoxCollider2(BoxCollider& collider, float timeDelta)
 {
-	const AABB& aabb = collider.GetAABB();
-	//const glm::vec3 extents = aabb.max - aabb.min;
-
+	ZoneScoped;
 	glm::vec3 velocity = collider.GetVelocity();
 	//if (!collider.GetSlideMask(BlockFace::Bottom))
 	{
 		velocity = velocity + glm::vec3(0, -75, 0) * (timeDelta / 1000.f);
-		collider.SetVelocity(velocity);
 	}
-	glm::vec3 targetDir = velocity * (timeDelta / 1000.f);
-
-	AABB translatedAABB = aabb;
-	translatedAABB.Translate(targetDir);
-
-	glm::i32vec3 voxelSpaceNewMin = translatedAABB.min * float(UNIT_VOXEL_RESOLUTION);
-	glm::i32vec3 voxelSpaceStartMin = aabb.min * float(UNIT_VOXEL_RESOLUTION);
-	glm::i32vec3 voxelSpaceNewMax = translatedAABB.min * float(UNIT_VOXEL_RESOLUTION);
-	glm::i32vec3 voxelSpaceStartMax = aabb.min * float(UNIT_VOXEL_RESOLUTION);
-
-	// need to also check max
-	if (voxelSpaceNewMin == voxelSpaceStartMin)
+	const glm::vec3 targetDir = velocity * (timeDelta / 1000.f);
+	if (targetDir == glm::vec3(0))
 	{
-		collider.Translate(targetDir);
+		collider.SetVelocity(velocity);
 		return;
 	}
 
-	AABB combinedAABB = AABB(glm::min(aabb.min, translatedAABB.min), glm::max(aabb.max, translatedAABB.max));
-	glm::i32vec3 voxelSpaceExtents = glm::ceil(combinedAABB.Extents() * float(UNIT_VOXEL_RESOLUTION) + glm::vec3(1));
-
-	bool* localBlocks = new bool[voxelSpaceExtents.x * voxelSpaceExtents.y * voxelSpaceExtents.z];
-
-	// TODO:: lots of optimizations possible here. not re-grabbing chunks every iteration. better prioritization of AABB checking in second loop
-	// should check AABB's closest in direction of movement first. combining neighboring AABBs to do less checks. 
-	// can think of combining AABBs as max of 3 planes around AABB. start will always be in a corner and will always be empty. so combine those ones in planes around start on each axis
-	glm::vec3 offset = { 0,0,0 };
-	glm::vec3 currentPos;
-	int index = 0;
-	for (int i = 0; i < voxelSpaceExtents.x; i++)
+	// once IsMeshReady is true, the volume only gets written on the main thread by ProcessEdits. before that the generation job
+	// still writes it, overlay edits included (EditOverlays::WriteIntoChunk calls WriteVoxelRow on the worker). so the IsMeshReady
+	// check is what makes reading it here safe, and IsMeshReady must never go true before that job is finished with the volume
+	auto getChunk = [this](const glm::i32vec3& chunkCoord) -> const Chunk*
 	{
-		offset.x = i;
-		for (int j = 0; j < voxelSpaceExtents.y; j++)
-		{
-			offset.y = j;
-			for (int k = 0; k < voxelSpaceExtents.z; k++)
-			{
-				offset.z = k;
-				currentPos = combinedAABB.min + offset * VOXEL_UNIT_SIZE;
-				// need to solve edge case if outside the octree
-				Chunk* currChunk = m_octree.GetChunkAtWorldPos(currentPos);
-				if (currChunk == nullptr || !currChunk->IsDeletable() || currChunk->GetLOD() != 0)
-					return;
-
-				localBlocks[index++] = currChunk->VoxelIsCollideableAtWorldPos(currentPos);
-			}
-		}
-	}
-
-	AABB voxelAABB;
-	glm::vec3 roundedMin = glm::vec3(glm::i32vec3(combinedAABB.min * float(UNIT_VOXEL_RESOLUTION))) * VOXEL_UNIT_SIZE;
-	glm::vec3 voxelAABBMin;
-	float tFirst[3] = { 1, 1, 1 }, tLast[3] = { 1, 1, 1 };
-	float tFirstTemp = 0, tLastTemp = 0;
-	bool collided[3] = { false };
-	int intersectionAxis;
+		const Chunk* chunk = m_octree.GetChunkAtWorldPos((glm::vec3(chunkCoord) + 0.5f) * float(CHUNK_UNIT_SIZE), 0);
+		return (chunk != nullptr && chunk->IsMeshReady()) ? chunk : nullptr;
+	};
+
+	glm::vec3 moved;
+	bool collided[3];
+	// the terrain around us isnt loaded yet. hold still instead of falling, or gravity piles up until it is
+	if (!m_collision.Sweep(collider.GetAABB(), targetDir, getChunk, moved, collided))
+		return;
+	collider.SetVelocity(velocity);
+	collider.Translate(moved);
 	for (int a = 0; a < 3; a++)
 	{
-		index = 0;
-		if (targetDir[a] == 0.0f)
-			continue;
-		glm::vec3 targetDirElement = glm::vec3(0);
-		targetDirElement[a] = targetDir[a];
-		for (int i = 0; i < voxelSpaceExtents.x; i++)
-		{
-			offset.x = i;
-			for (int j = 0; j < voxelSpaceExtents.y; j++)
-			{
-				offset.y = j;
-				for (int k = 0; k < voxelSpaceExtents.z; k++)
-				{
-					offset.z = k;
-					if (localBlocks[index++])
-					{
-						voxelAABBMin = roundedMin + offset * VOXEL_UNIT_SIZE;
-						voxelAABB = { voxelAABBMin, voxelAABBMin + glm::vec3(VOXEL_UNIT_SIZE) };
-						// this is potentially problematic. if theres two AABBs in our path, and were going fast enough to collide with both of them. then only one will get collided with. and it could be the further one.
-						// need to sort by distance or something. combining would help a bit.
-						if (IntersectMovingAABBAABBAxis(voxelAABB, aabb, glm::vec3(0), targetDirElement, 0, tFirstTemp, tLastTemp, a) != 0)
-						{
-							collided[a] = true;
-							tFirst[a] = glm::min(tFirst[a], tFirstTemp);
-							tLast[a] = glm::min(tLast[a], tLastTemp);
-						}
-					}
-				}
-			}
-		}
 		if (collided[a])
-		{
-			//collider.Translate(targetDirElement * glm::min(tFirst[a], 1.0f) * 0.999f);
 			collider.SetVelocityIndex(a, 0);
-		}
-		else
-		{
-			collider.Translate(targetDirElement);
-		}
 	}
-
-	//for (int a = 0; a < 3; a++)
-	//{
-	//	glm::vec3 targetDirElement = glm::vec3(0);
-	//	targetDirElement[a] = targetDir[a];
-	//	if (collided[a])
-	//	{
-	//		//collider.Translate(targetDirElement * glm::min(tFirst[a], 1.0f) * 0.999f);
-	//		collider.SetVelocityIndex(a, 0);
-	//	}
-	//	else
-	//	{
-	//		collider.Translate(targetDirElement);
-	//	}
-	//}
-
-	fprintf(stderr, "Colliding on %d, %d, %d\n", collided[0], collided[1], collided[2]);
-
-	delete[] localBlocks;
 }
 
 bool VoxelScene::RayCast(const Ray& ray, VoxelRayHit& voxelRayHit)
 {
 	// need to solve edge case if outside the octree
 	Chunk* currChunk = m_octree.GetChunkAtWorldPos(ray.origin);
-	if (currChunk == nullptr || !currChunk->IsDeletable() || currChunk->GetLOD() != 0)
+	if (currChunk == nullptr || !currChunk->IsMeshReady() || currChunk->GetLOD() != 0)
 		return false;
 
 	//fprintf(stderr, "%f %f %f\n", ray.dir.x, ray.dir.y, ray.dir.z);
@@ -694,7 +759,7 @@ bool VoxelScene::RayCast(const Ray& ray, VoxelRayHit& voxelRayHit)
 			// bump a little in that direction to make sure were in that new chunk and not right on the edge
 			glm::vec3 currPos = ray.origin + ray.dir * (lastT + 0.001f);
 			currChunk = m_octree.GetChunkAtWorldPos(currPos);
-			if (currChunk == nullptr || !currChunk->IsDeletable() || currChunk->GetLOD() != 0)
+			if (currChunk == nullptr || !currChunk->IsMeshReady() || currChunk->GetLOD() != 0)
 				return false;
 			currChunk->GetVoxelIndexAtWorldPos(currPos, voxelIndex);
 			exitedChunk = false;
@@ -719,38 +784,354 @@ bool VoxelScene::DeleteBlock(const Ray& ray)
 {
 	VoxelRayHit hit;
 	if (RayCast(ray, hit))
+		EditVoxel(hit.chunk, hit.voxelIndex, Chunk::BlockType::Air);
+	return true;
+}
+
+void VoxelScene::EditVoxel(Chunk* chunk, const glm::i32vec3& index, Chunk::BlockType type)
+{
+	QueueVoxelEdit(chunk, index, type);
+
+	// neighbors keep a copy of our outermost layer as their border. edge and corner ones too since ao reads those
+	const float voxelSize = chunk->GetScale() * VOXEL_UNIT_SIZE;
+	const glm::vec3 voxelCenter = chunk->m_chunkPos + (glm::vec3(index) + 0.5f) * voxelSize;
+	for (int x = -1; x <= 1; x++)
 	{
-		hit.chunk->DeleteBlockAtIndex(hit.voxelIndex);
-		hit.chunk->GenerateMesh();
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int z = -1; z <= 1; z++)
+			{
+				const glm::i32vec3 dir(x, y, z);
+				if (dir == glm::i32vec3(0))
+					continue;
+				bool onBorder = true;
+				for (int i = 0; i < 3; i++)
+				{
+					if (dir[i] != 0 && index[i] != (dir[i] > 0 ? CHUNK_VOXEL_SIZE - 1 : 0))
+						onBorder = false;
+				}
+				if (!onBorder)
+					continue;
+
+				Chunk* neighbor = m_octree.GetChunkAtWorldPos(voxelCenter + glm::vec3(dir) * voxelSize);
+				// voxels only line up with neighbors of the same lod
+				if (neighbor == nullptr || neighbor == chunk || neighbor->GetLOD() != chunk->GetLOD())
+					continue;
+				QueueVoxelEdit(neighbor, index - dir * CHUNK_VOXEL_SIZE, type);
+			}
+		}
+	}
+}
 
-		for (int i = 0; i < 3; i++)
+void VoxelScene::QueueVoxelEdit(Chunk* chunk, const glm::i32vec3& index, Chunk::BlockType type)
+{
+	// carving air out of air
+	if (chunk->IsEmpty() && chunk->IsDone() && type == Chunk::BlockType::Air)
+		return;
+
+	std::vector<VoxelEdit>& edits = m_pendingEdits[chunk];
+	chunk->SetEditsPending(true);
+	// hitting the same voxel again before the last write went in just replaces it
+	for (VoxelEdit& edit : edits)
+	{
+		if (edit.index == index && edit.length == 1)
 		{
-			glm::vec3 dir = glm::vec3(0);
-			dir[i] = 1;
+			edit.type = type;
+			return;
+		}
+	}
+	edits.push_back({ index, 1, type });
+}
 
-			if (hit.voxelIndex[i] >= CHUNK_VOXEL_SIZE - 1)
+bool VoxelScene::GetLOD0ChunksInAABB(const AABB& bounds, std::vector<Chunk*>& chunks)
+{
+	const glm::i32vec3 minCoord(glm::floor(bounds.min / float(CHUNK_UNIT_SIZE)));
+	const glm::i32vec3 maxCoord(glm::floor(bounds.max / float(CHUNK_UNIT_SIZE)));
+	bool covered = true;
+	for (int x = minCoord.x; x <= maxCoord.x; x++)
+	{
+		for (int y = minCoord.y; y <= maxCoord.y; y++)
+		{
+			for (int z = minCoord.z; z <= maxCoord.z; z++)
 			{
-				Chunk* neighborChunk = m_octree.GetChunkAtWorldPos(hit.voxelHitPosition + dir * float(1u << hit.chunk->GetLOD()) * 1.5f);
-				glm::i8vec3 neighborIndex = hit.voxelIndex;
-				neighborIndex += glm::i8vec3(1);
-				neighborIndex[i] = 0;
-				neighborChunk->DeleteBlockAtInternalIndex(neighborIndex);
-				neighborChunk->GenerateMesh();
+				if (Chunk* chunk = m_octree.GetChunkAtWorldPos((glm::vec3(x, y, z) + 0.5f) * float(CHUNK_UNIT_SIZE), 0))
+					chunks.push_back(chunk);
+				else
+					covered = false;
 			}
-			else if (hit.voxelIndex[i] <= 0)
+		}
+	}
+	return covered;
+}
+
+bool VoxelScene::EditRegion(const AABB& bounds, const RegionRowFunction& regionRow, Chunk::BlockType type)
+{
+	ZoneScoped;
+	// only lod 0 volumes get written. ProcessEdits keeps those in the overlays, which is how coarser lods and chunks that
+	// generate later see the edit. a coarse chunk written directly would lose it the next time it regenerates or splits
+	m_regionEditChunks.clear();
+	if (!GetLOD0ChunksInAABB(bounds, m_regionEditChunks))
+		return false;
+	// a lod 0 voxel of slack so chunks next to the region still pick it up in their border. ones that arent lod 0
+	// get it from the overlays when they generate
+	const glm::vec3 slack(VOXEL_UNIT_SIZE);
+	m_regionEditChunks.clear();
+	GetLOD0ChunksInAABB(AABB(bounds.min - slack, bounds.max + slack), m_regionEditChunks);
+
+	for (Chunk* chunk : m_regionEditChunks)
+	{
+		if (chunk->IsEmpty() && chunk->IsDone() && type == Chunk::BlockType::Air)
+			continue;
+
+		// range of voxels, border included, whose centers can be inside bounds
+		const float voxelSize = chunk->GetScale() * VOXEL_UNIT_SIZE;
+		const glm::vec3 chunkPos = chunk->GetChunkPos();
+		const glm::i32vec3 minIndex = glm::max(glm::i32vec3(glm::ceil((bounds.min - chunkPos) / voxelSize - 0.5f)), glm::i32vec3(-1));
+		const glm::i32vec3 maxIndex = glm::min(glm::i32vec3(glm::floor((bounds.max - chunkPos) / voxelSize - 0.5f)), glm::i32vec3(CHUNK_VOXEL_SIZE));
+		if (minIndex.x > maxIndex.x || minIndex.y > maxIndex.y || minIndex.z > maxIndex.z)
+			continue;
+
+		std::vector<VoxelEdit>* edits = nullptr;
+		const int rowLength = maxIndex.z - minIndex.z + 1;
+		for (int x = minIndex.x; x <= maxIndex.x; x++)
+		{
+			for (int y = minIndex.y; y <= maxIndex.y; y++)
 			{
-				Chunk* neighborChunk = m_octree.GetChunkAtWorldPos(hit.voxelHitPosition - dir * float(1u << hit.chunk->GetLOD()) * .5f);
-				glm::i8vec3 neighborIndex = hit.voxelIndex;
-				neighborIndex += glm::i8vec3(1);
-				neighborIndex[i] = Chunk::INT_CHUNK_VOXEL_SIZE - 1;
-				neighborChunk->DeleteBlockAtInternalIndex(neighborIndex);
-				neighborChunk->GenerateMesh();
+				const glm::vec3 rowStart = chunkPos + (glm::vec3(x, y, minIndex.z) + 0.5f) * voxelSize;
+				m_regionEditRuns.clear();
+				regionRow(rowStart, voxelSize, rowLength, m_regionEditRuns);
+				for (const glm::ivec2& run : m_regionEditRuns)
+				{
+					if (edits == nullptr)
+					{
+						edits = &m_pendingEdits[chunk];
+						chunk->SetEditsPending(true);
+					}
+					edits->push_back({ glm::i32vec3(x, y, minIndex.z + run.x), run.y - run.x, type });
+				}
 			}
 		}
 	}
 	return true;
 }
 
+// the run of voxel centers along a row that fall in [zMin, zMax]
+static void AppendRowRun(float zMin, float zMax, const glm::vec3& rowStart, float voxelSize, int count, std::vector<glm::ivec2>& runs)
+{
+	const int begin = std::max(int(std::ceil((zMin - rowStart.z) / voxelSize)), 0);
+	const int end = std::min(int(std::floor((zMax - rowStart.z) / voxelSize)) + 1, count);
+	if (end > begin)
+		runs.push_back({ begin, end });
+}
+
+bool VoxelScene::EditSphere(const glm::vec3& center, float radius, Chunk::BlockType type)
+{
+	return EditRegion(AABB(center - radius, center + radius), [center, radius](const glm::vec3& rowStart, float voxelSize, int count, std::vector<glm::ivec2>& runs)
+		{
+			const float dx = rowStart.x - center.x;
+			const float dy = rowStart.y - center.y;
+			const float halfLengthSq = radius * radius - dx * dx - dy * dy;
+			if (halfLengthSq < 0.0f)
+				return;
+			const float halfLength = std::sqrt(halfLengthSq);
+			AppendRowRun(center.z - halfLength, center.z + halfLength, rowStart, voxelSize, count, runs);
+		}, type);
+}
+
+bool VoxelScene::EditBox(const AABB& box, Chunk::BlockType type)
+{
+	// EditRegion already limits rows to the bounds
+	return EditRegion(box, [](const glm::vec3&, float, int count, std::vector<glm::ivec2>& runs)
+		{
+			runs.push_back({ 0, count });
+		}, type);
+}
+
+bool VoxelScene::EditCylinder(const glm::vec3& base, float radius, float height, Chunk::BlockType type)
+{
+	const AABB bounds(base - glm::vec3(radius, 0, radius), base + glm::vec3(radius, height, radius));
+	return EditRegion(bounds, [base, radius](const glm::vec3& rowStart, float voxelSize, int count, std::vector<glm::ivec2>& runs)
+		{
+			const float dx = rowStart.x - base.x;
+			const float halfLengthSq = radius * radius - dx * dx;
+			if (halfLengthSq < 0.0f)
+				return;
+			const float halfLength = std::sqrt(halfLengthSq);
+			AppendRowRun(base.z - halfLength, base.z + halfLength, rowStart, voxelSize, count, runs);
+		}, type);
+}
+
+bool VoxelScene::EditSDF(const AABB& bounds, const std::function<float(const glm::vec3&)>& sdf, Chunk::BlockType type)
+{
+	return EditRegion(bounds, [&sdf](const glm::vec3& rowStart, float voxelSize, int count, std::vector<glm::ivec2>& runs)
+		{
+			int runStart = -1;
+			for (int i = 0; i < count; i++)
+			{
+				const bool inside = sdf(rowStart + glm::vec3(0, 0, i * voxelSize)) <= 0.0f;
+				if (inside && runStart < 0)
+				{
+					runStart = i;
+				}
+				else if (!inside && runStart >= 0)
+				{
+					runs.push_back({ runStart, i });
+					runStart = -1;
+				}
+			}
+			if (runStart >= 0)
+				runs.push_back({ runStart, count });
+		}, type);
+}
+
+bool VoxelScene::BrushStroke(const Ray& ray)
+{
+	VoxelRayHit hit;
+	if (!RayCast(ray, hit))
+		return false;
+	return EditSphere(hit.hitPosition, m_brushRadius, Chunk::BlockType::Air);
+}
+
+bool VoxelScene::IsRegionLoaded(const AABB& bounds)
+{
+	m_regionEditChunks.clear();
+	if (!GetLOD0ChunksInAABB(bounds, m_regionEditChunks))
+		return false;
+	for (Chunk* chunk : m_regionEditChunks)
+	{
+		if (!chunk->IsMeshReady())
+			return false;
+	}
+	return true;
+}
+
+void VoxelScene::ProcessEdits()
+{
+	ZoneScoped;
+	m_drainedEditCompletions.clear();
+	m_editRemeshedCompletions.Drain(m_drainedEditCompletions);
+	for (const EditRemeshed& completion : m_drainedEditCompletions)
+	{
+		Chunk* chunk = completion.chunk;
+		if (!chunk->IsRetired())
+		{
+			chunk->SwapInEditedMesh();
+			m_editRemeshChunks.erase(chunk);
+			if (m_pendingEdits.find(chunk) == m_pendingEdits.end())
+				chunk->SetEditsPending(false);
+		}
+		m_chunkReclaimer.Exit(completion.epoch);
+	}
+
+	// one remesh per dirty chunk per frame. chunks still remeshing or generating keep collecting edits for later
+	for (auto it = m_pendingEdits.begin(); it != m_pendingEdits.end(); )
+	{
+		Chunk* chunk = it->first;
+		if (m_editRemeshChunks.count(chunk) || !chunk->CanApplyEdits())
+		{
+			++it;
+			continue;
+		}
+
+		// the first solid voxels in an all air chunk need the neighbors real border under them, not air
+		if (chunk->IsEmpty() && std::any_of(it->second.begin(), it->second.end(), [](const VoxelEdit& edit) { return edit.type != Chunk::BlockType::Air; }))
+			CopyNeighborBorders(chunk);
+
+		Chunk::DirtyPlanes dirtyPlanes;
+		// voxel and region edits only ever write lod 0. coarser edits came out of the overlays to begin with
+		const bool keepInOverlay = chunk->GetLOD() == 0;
+		const glm::i32vec3 overlayKey = EditOverlays::GetKey(chunk->GetChunkPos(), 0);
+		for (const VoxelEdit& edit : it->second)
+		{
+			chunk->WriteVoxelRow(edit.index, edit.length, edit.type);
+			dirtyPlanes.AddVoxels(edit.index, edit.index + glm::i32vec3(0, 0, edit.length - 1));
+			if (keepInOverlay)
+				m_editOverlayRows.push_back({ overlayKey, { edit.index, edit.length, edit.type } });
+		}
+		m_editRemeshChunks.insert(chunk);
+		// exited once the completion is drained
+		const unsigned epoch = m_chunkReclaimer.Enter();
+		m_threadPool.Submit([this, chunk, dirtyPlanes, epoch]()
+			{
+				if (!chunk->IsRetired())
+					chunk->RemeshEdits(dirtyPlanes);
+				AddToEditRemeshedCallback(chunk, epoch);
+			}, Priority_Max);
+		it = m_pendingEdits.erase(it);
+	}
+
+	ProcessEditOverlays();
+}
+
+void VoxelScene::CopyNeighborBorders(Chunk* chunk)
+{
+	const Chunk* neighbors[3][3][3] = {};
+	const float chunkSize = CHUNK_UNIT_SIZE * chunk->GetScale();
+	const glm::vec3 center = chunk->GetChunkPos() + chunkSize * 0.5f;
+	for (int x = 0; x < 3; x++)
+	{
+		for (int y = 0; y < 3; y++)
+		{
+			for (int z = 0; z < 3; z++)
+			{
+				// ones still generating get their volume written on a worker, and pick our edits up from the overlays anyway
+				Chunk* neighbor = m_octree.GetChunkAtWorldPos(center + glm::vec3(x - 1, y - 1, z - 1) * chunkSize, chunk->GetLOD());
+				if (neighbor != nullptr && neighbor != chunk && neighbor->IsMeshReady())
+					neighbors[x][y][z] = neighbor;
+			}
+		}
+	}
+	chunk->CopyBorderFromNeighbors(neighbors);
+}
+
+void VoxelScene::ProcessEditOverlays()
+{
+	ZoneScoped;
+	std::vector<EditOverlays::LevelChange> changes;
+	{
+		std::lock_guard lock(m_editOverlayChangesMutex);
+		if (m_editOverlayJobDone)
+		{
+			changes.swap(m_editOverlayChanges);
+			m_editOverlayJobDone = false;
+			m_editOverlayJobInFlight = false;
+		}
+	}
+
+	for (const EditOverlays::LevelChange& change : changes)
+	{
+		// chunks that dont exist yet pick the overlay up when they generate
+		Chunk* chunk = m_octree.GetChunkAtWorldPos(EditOverlays::GetChunkCenter(change.key, change.level), change.level);
+		if (chunk == nullptr)
+			continue;
+
+		std::vector<VoxelEdit>* edits = nullptr;
+		for (const EditOverlays::Row& row : change.rows)
+		{
+			if (chunk->IsEmpty() && chunk->IsDone() && row.type == Chunk::BlockType::Air)
+				continue;
+			if (edits == nullptr)
+			{
+				edits = &m_pendingEdits[chunk];
+				chunk->SetEditsPending(true);
+			}
+			edits->push_back({ row.start, row.length, row.type });
+		}
+	}
+
+	if (!m_editOverlayJobInFlight && !m_editOverlayRows.empty())
+	{
+		m_editOverlayJobInFlight = true;
+		m_threadPool.Submit([this, rows = std::move(m_editOverlayRows)]()
+			{
+				std::vector<EditOverlays::LevelChange> changes;
+				m_editOverlays.Apply(rows, changes);
+				AddToEditOverlayCallback(changes);
+			}, Priority_Low);
+		m_editOverlayRows.clear();
+	}
+}
+
 // TODO:: turn this into an indexed draw on single cube mesh
 void VoxelScene::RenderDebugBoundingBoxes(const Camera* camera, const Camera* debugCullCamera)
 {
@@ -763,14 +1144,13 @@ void VoxelScene::RenderDebugBoundingBoxes(const Camera* camera, const Camera* de
 	//glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix() * glm::mat4(1)));
 	glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(camera->GetProjMatrix()));
 
-	glm::mat4x4 modelMat;
 	for (Chunk* chunk : m_frameChunks)
 	{
 		if (chunk->IsEmpty())
 			continue;
 
-		chunk->GetModelMat(modelMat);
-		glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix() * glm::scale(modelMat, glm::vec3(UNIT_VOXEL_RESOLUTION))));
+		const glm::mat4 modelMat = glm::scale(glm::translate(glm::mat4(1.0f), chunk->GetChunkPos()), glm::vec3(chunk->GetScale()));
+		glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix() * modelMat));
 
 		glDrawElements(GL_LINES, m_aabbIndexCount, GL_UNSIGNED_INT, 0);
 	}
@@ -809,10 +1189,31 @@ void VoxelScene::RenderHitPos(const Camera* camera, const Camera* debugCullCamer
 #ifdef IMGUI_ENABLED
 void VoxelScene::RenderImGui()
 {
-	ImGui::Text("%d vertices", s_imguiData.numVerts);
+	ImGui::Text("%d quads", s_imguiData.numQuads);
 	ImGui::Text("%d render chunks", s_imguiData.numRenderChunks);
+	ImGui::Text("%d visible chunks", s_imguiData.numVisibleChunks);
+	ImGui::Checkbox("Cave Culling", &RenderSettings::Get().caveCulling);
+	ImGui::Checkbox("Face Direction Culling", &RenderSettings::Get().faceDirectionCulling);
+	ImGui::Checkbox("Batch Skirt Noise", &RenderSettings::Get().batchSkirtNoise);
+	ImGui::Checkbox("Cache Column Noise", &RenderSettings::Get().cacheColumnNoise);
+	ImGui::Checkbox("Parallel Noise Grids", &RenderSettings::Get().parallelNoiseGrids);
+	ImGui::SliderInt("LOD 0 Generation Slabs", &RenderSettings::Get().generationSlabs, 1, 8);
+	ImGui::Checkbox("Split LOD 0 Mesh Sweeps", &RenderSettings::Get().splitMeshSweeps);
+	ImGui::Checkbox("Fused Generate + Mesh", &RenderSettings::Get().fusedMeshing);
+	ImGui::Checkbox("Staged Uploads", &RenderSettings::Get().stagedUploads);
+	ImGui::SliderInt("Upload Budget KB", &RenderSettings::Get().uploadBudgetKB, 64, 16384, "%d", ImGuiSliderFlags_Logarithmic);
+	ImGui::Text("%u uploads (%.1f KB), %u queued (%.1f KB)", s_imguiData.numUploads, s_imguiData.uploadedBytes / 1024.0,
+		s_imguiData.numQueuedUploads, s_imguiData.queuedUploadBytes / 1024.0);
+	ImGui::Text("mesh to drawable %.2fms avg %.2fms max", s_imguiData.avgUploadLatencyMs, s_imguiData.maxUploadLatencyMs);
 	ImGui::Text("%d total chunks", s_imguiData.numTotalChunks);
+	ImGui::Text("%d retired chunks waiting on workers", int(m_chunkReclaimer.GetRetiredCount()));
+	ImGui::Text("%.1f chunk allocs/s, %.1f reused/s, %.1f gl buffers/s, %d pooled", s_imguiData.chunkAllocationsPerSec,
+		s_imguiData.chunkReusesPerSec, s_imguiData.bufferCreationsPerSec, int(m_octree.GetChunkPool().GetFreeCount()));
 	ImGui::Text("%f avg gen time", s_imguiData.avgChunkGenTime);
+	ImGui::Text("%d edit overlays", int(m_editOverlays.GetOverlayCount()));
+	const NoiseColumnCache& columnCache = Chunk::GetNoiseColumnCache();
+	ImGui::Text("column noise %llu hits %llu misses", (unsigned long long)columnCache.GetHits(), (unsigned long long)columnCache.GetMisses());
+	ImGui::Text("%.2f MB of meshes waiting on upload", Chunk::GetResidentQuadBytes() / (1024.0 * 1024.0));
 
 	ImGui::SliderFloat("cave frequency", &m_chunkGenParamsNext.caveFrequency, 0.01f, 100.f, "%.2f", ImGuiSliderFlags_Logarithmic);
 	ImGui::SliderFloat("Terrain Height", &m_chunkGenParamsNext.terrainHeight, 1.f, 2000.f, "%.2f", ImGuiSliderFlags_Logarithmic);
@@ -821,6 +1222,16 @@ void VoxelScene::RenderImGui()
 	ImGui::SliderFloat("Terrain Frequency", &m_chunkGenParamsNext.terrainFrequency, 0.01f, 100.f, "%.2f", ImGuiSliderFlags_Logarithmic);
 	ImGui::InputInt("Terrain Octaves", &m_chunkGenParamsNext.terrainOctaves, 1, 10);
 	ImGui::Checkbox("Debug Terrain", &m_chunkGenParamsNext.m_debugFlatWorld);
+	ImGui::Checkbox("Ambient Occlusion", &m_chunkGenParamsNext.ambientOcclusion);
+	ImGui::Checkbox("Downsample LODs", &m_chunkGenParamsNext.downsampleLODs);
+	ImGui::Checkbox("Classify Volumes", &m_chunkGenParamsNext.classifyVolumes);
+	ImGui::Checkbox("Adaptive Density", &m_chunkGenParamsNext.adaptiveDensity);
+	ImGui::SliderFloat("Adaptive Density Error", &m_chunkGenParamsNext.adaptiveDensityError, 0.001f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+	ImGui::SliderInt("Cave Max LOD", &m_chunkGenParamsNext.caveMaxLOD, 0, 8);
+	ImGui::SliderInt("Cave Coarse LOD", &m_chunkGenParamsNext.caveCoarseLOD, 0, 8);
+	ImGui::SliderInt("Biome Max LOD", &m_chunkGenParamsNext.biomeMaxLOD, 0, 8);
+	ImGui::SliderInt("Dirt Max LOD", &m_chunkGenParamsNext.dirtMaxLOD, 0, 8);
+	ImGui::SliderFloat("Brush Radius", &m_brushRadius, 0.5f, 20.0f);
 }
 #endif
 
@@ -831,14 +1242,24 @@ glm::i32vec3 VoxelScene::ConvertWorldPosToChunkPos(const glm::vec3& worldPos)
 
 void VoxelScene::AddToMeshListCallback(Chunk* chunk)
 {
-	std::lock_guard lock(m_generateMeshCallbackListMutex);
-	m_generateMeshCallbackList.push_back(chunk);
+	m_meshCompletions.Push(chunk);
+}
+
+void VoxelScene::AddToEditRemeshedCallback(Chunk* chunk, unsigned epoch)
+{
+	m_editRemeshedCompletions.Push({ chunk, epoch });
+}
+
+void VoxelScene::AddToEditOverlayCallback(std::vector<EditOverlays::LevelChange>& changes)
+{
+	std::lock_guard lock(m_editOverlayChangesMutex);
+	m_editOverlayChanges.swap(changes);
+	m_editOverlayJobDone = true;
 }
 
 void VoxelScene::AddToRenderListCallback(Chunk* chunk)
 {
-	std::lock_guard lock(m_renderCallbackListMutex);
-	m_renderCallbackList.push_back(chunk);
+	m_renderCompletions.Push(chunk);
 }
 
 void VoxelScene::LogVector(const glm::vec3& v)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
 #include <list>
 #include <deque>
 #include <mutex>
@@ -11,10 +12,14 @@
 #include "Chunk.h"
 #include "glm/gtx/hash.hpp"
 #include "Octree.h"
+#include "EditOverlays.h"
 #include "ShaderProgram.h"
 #include "ThreadPool.h"
+#include "MPSCQueue.h"
+#include "EpochReclaimer.h"
 #include "Collider.h"
 #include "BoxCollider.h"
+#include "VoxelCollision.h"
 
 class Chunk;
 class Camera;
@@ -42,6 +47,8 @@ public:
 	~VoxelScene();
 
 	static void InitShared();
+	// shared with the headless benchmarks so they generate the same terrain. compiles TerrainGraph::GetPath()
+	static void CreateNoiseGenerators(Chunk::ChunkNoiseGenerators& generators);
 
 	Chunk* CreateChunk(const glm::i32vec3& chunkPos);
 	void Update(const glm::vec3& position);
@@ -53,6 +60,26 @@ public:
 	void RenderTransparency(const Camera* camera, const Camera* debugCullCamera);
 	bool RayCast(const Ray& ray, VoxelRayHit& voxelRayHit);
 	bool DeleteBlock(const Ray& ray);
+	// queues a voxel write, index is 0..CHUNK_VOXEL_SIZE - 1. neighbors that keep a copy of it in their border get it too.
+	// writes are applied and remeshed on the pool in ProcessEdits, the old mesh renders until then
+	void EditVoxel(Chunk* chunk, const glm::i32vec3& index, Chunk::BlockType type);
+
+	// region edits. Air carves, anything else fills. every lod 0 chunk overlapping the region writes it into its volume,
+	// border included so neighbors stay in sync. remeshing goes through the same queue as EditVoxel, and coarser lods get it
+	// from the overlays. returns false and edits nothing if part of the region is outside the lod 0 chunks in the octree
+	bool EditSphere(const glm::vec3& center, float radius, Chunk::BlockType type);
+	bool EditBox(const AABB& box, Chunk::BlockType type);
+	// y axis aligned, base is the center of the bottom cap
+	bool EditCylinder(const glm::vec3& base, float radius, float height, Chunk::BlockType type);
+	// sdf(pos) <= 0 is inside. bounds has to contain all of the inside
+	bool EditSDF(const AABB& bounds, const std::function<float(const glm::vec3&)>& sdf, Chunk::BlockType type);
+	// carves a sphere where the ray hits
+	bool BrushStroke(const Ray& ray);
+	// every lod 0 chunk overlapping bounds is in the octree and meshed, so edits and raycasts there see the real volume
+	bool IsRegionLoaded(const AABB& bounds);
+	// edits still waiting to be written, or remeshing on the pool and not swapped in yet
+	bool HasPendingEdits() const { return !m_pendingEdits.empty() || !m_editRemeshChunks.empty(); }
+	uint GetPendingEditChunkCount() const { return uint(m_pendingEdits.size()); }
 	void ResolveBoxCollider(BoxCollider& collider, float timeDelta);
 	void ResolveBoxCollider2(BoxCollider& collider, float timeDelta);
 #ifdef IMGUI_ENABLED
@@ -64,14 +91,29 @@ public:
 
 	void AddToMeshListCallback(Chunk* chunk);
 	void AddToRenderListCallback(Chunk* chunk);
+	void AddToEditRemeshedCallback(Chunk* chunk, unsigned epoch);
+	void AddToEditOverlayCallback(std::vector<EditOverlays::LevelChange>& changes);
 	void LogVector(const glm::vec3& v);
 
 	struct ImguiData
 	{
-		uint numVerts;
+		uint numQuads;
 		uint numRenderChunks;
+		uint numVisibleChunks;
 		uint numTotalChunks;
 		double avgChunkGenTime;
+		// staged uploads, for the last frame
+		uint numUploads;
+		uint64_t uploadedBytes;
+		uint numQueuedUploads;
+		uint64_t queuedUploadBytes;
+		// mesh done on a worker to drawable
+		double avgUploadLatencyMs;
+		double maxUploadLatencyMs;
+		// octree churn over the last second. chunks built from scratch vs recycled by the pool
+		double chunkAllocationsPerSec;
+		double chunkReusesPerSec;
+		double bufferCreationsPerSec;
 	};
 	static ImguiData s_imguiData;
 
@@ -79,20 +121,75 @@ public:
 private:
 	void RenderDebugBoundingBoxes(const Camera* camera, const Camera* debugCullCamera);
 	void RenderHitPos(const Camera* camera, const Camera* debugCullCamera);
+	void TraverseVisibility(const Camera* camera);
+	// uploads this frames chunks that have a mesh waiting, within RenderSettings::uploadBudgetKB
+	void UploadMeshes(const glm::vec3& cameraPos, const Frustum& frustum, bool caveCulling);
+	void QueueVoxelEdit(Chunk* chunk, const glm::i32vec3& index, Chunk::BlockType type);
+	void ProcessEdits();
+	// the neighbors of an all air chunk that are done generating, for Chunk::CopyBorderFromNeighbors
+	void CopyNeighborBorders(Chunk* chunk);
+	// pushes lod 0 edits into m_editOverlays on the pool, coarser chunks that changed because of them get queued like any edit
+	void ProcessEditOverlays();
+	// hands chunks that left the octree to m_chunkReclaimer, along with any edits still waiting on them
+	void RetireChunks(std::vector<Chunk*>& chunks);
+	// appends [begin, end) runs of the count voxels along z starting at the voxel center rowStart that are inside the region
+	using RegionRowFunction = std::function<void(const glm::vec3& rowStart, float voxelSize, int count, std::vector<glm::ivec2>& runs)>;
+	bool EditRegion(const AABB& bounds, const RegionRowFunction& regionRow, Chunk::BlockType type);
+	// appends the lod 0 chunks overlapping bounds. false if some of bounds has no lod 0 chunk, chunks still gets the ones that do
+	bool GetLOD0ChunksInAABB(const AABB& bounds, std::vector<Chunk*>& chunks);
 #ifdef DEBUG
 	void ValidateChunks();
 #endif
 
 	Octree m_octree;
 	std::unordered_map<glm::i32vec3, Chunk*> m_chunks;
+	// octree chunks get deleted through this, any state they were in. jobs and edit completions keep them alive
+	EpochReclaimer<Chunk> m_chunkReclaimer;
+	std::vector<Chunk*> m_retiredChunks;
+	// scratch for ResolveBoxCollider2, kept around so sweeps dont allocate
+	VoxelCollision m_collision;
+	// for the per second numbers in s_imguiData
+	ChunkPool::Stats m_lastPoolStats;
+	uint64_t m_lastBufferCreations = 0;
+	std::chrono::high_resolution_clock::time_point m_lastPoolStatsTime = std::chrono::high_resolution_clock::now();
 
 	std::deque<Chunk*> m_generateMeshList;
-	std::deque<Chunk*> m_generateMeshCallbackList;
-	std::list<Chunk*> m_renderList;	// even better, generate buffers on main not in render function so these can be const Chunk*
-	std::list<Chunk*> m_renderCallbackList;
+	std::vector<Chunk*> m_renderList;	// even better, generate buffers on main not in render function so these can be const Chunk*
 
-	std::mutex m_generateMeshCallbackListMutex;
-	std::mutex m_renderCallbackListMutex;
+	// workers report finished chunks through these, the main thread drains them all at once every frame
+	MPSCQueue<Chunk*> m_meshCompletions;
+	MPSCQueue<Chunk*> m_renderCompletions;
+	// edit completions get dereferenced when drained, so they hold on to the remesh jobs epoch until then
+	struct EditRemeshed
+	{
+		Chunk* chunk;
+		unsigned epoch;
+	};
+	MPSCQueue<EditRemeshed> m_editRemeshedCompletions;
+	std::vector<Chunk*> m_drainedCompletions;
+	std::vector<EditRemeshed> m_drainedEditCompletions;
+
+	// a run of voxels along z
+	struct VoxelEdit
+	{
+		glm::i32vec3 index;
+		int length;
+		Chunk::BlockType type;
+	};
+	// coalesced per chunk until the chunk can take them, then one remesh job per chunk per frame
+	std::unordered_map<Chunk*, std::vector<VoxelEdit>> m_pendingEdits;
+	std::unordered_set<Chunk*> m_editRemeshChunks;
+	std::vector<Chunk*> m_regionEditChunks;
+	std::vector<glm::ivec2> m_regionEditRuns;
+	float m_brushRadius = 3.0f;
+
+	EditOverlays m_editOverlays;
+	// lod 0 writes since the last overlay job. one job at a time, these wait for the next
+	std::vector<EditOverlays::KeyedRow> m_editOverlayRows;
+	bool m_editOverlayJobInFlight = false;
+	bool m_editOverlayJobDone = false;
+	std::vector<EditOverlays::LevelChange> m_editOverlayChanges;
+	std::mutex m_editOverlayChangesMutex;
 
 	static ShaderProgram s_chunkShaderProgram;
 	static ShaderProgram s_debugWireframeShaderProgram;
@@ -120,6 +217,25 @@ private:
 
 	bool m_useOctree = true;
 	std::vector<Chunk*> m_frameChunks;
+
+	struct VisibilityNode
+	{
+		Chunk* chunk;
+		int8_t entryFace;		// -1 for the chunk the camera is in
+		uint8_t travelledMask;	// directions weve stepped in to get here, we never step back towards the camera
+	};
+	std::vector<Chunk*> m_visibleChunks;
+	std::vector<VisibilityNode> m_visibilityQueue;
+	std::vector<Chunk*> m_visibilityNeighbors;
+	uint m_visibilityFrame = 0;
+
+	struct PendingUpload
+	{
+		Chunk* chunk;
+		bool hidden;		// culled this frame, goes after everything visible
+		float distance2;
+	};
+	std::vector<PendingUpload> m_uploadQueue;
 	glm::mat4 m_projMat;
 
 	Chunk::ChunkNoiseGenerators m_noiseGenerators;
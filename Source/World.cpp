@@ -96,6 +96,10 @@ void World::Update(float updateTime, InputData* inputData)
 	{
 		m_voxelScene.DeleteBlock({ m_player.GetCamera().GetPosition(), m_player.GetCamera().GetForward() });
 	}
+	if (inputData->m_mouseButtons.y)
+	{
+		m_voxelScene.BrushStroke({ m_player.GetCamera().GetPosition(), m_player.GetCamera().GetForward() });
+	}
 	VoxelScene::VoxelRayHit hit;
 	m_voxelScene.RayCast({ m_player.GetCamera().GetPosition(), m_player.GetCamera().GetForward()}, hit);
 
@@ -5,9 +5,12 @@
 #include "Input.h"
 #include "World.h"
 #include "GX.h"
+#include "Benchmark.h"
+#include "TerrainGraph.h"
 #include <GLFW/glfw3.h>
 
 #include <chrono>
+#include <cstring>
 #include <iostream>
 
 #ifdef IMGUI_ENABLED
@@ -23,8 +26,19 @@
 const unsigned int SCR_WIDTH = 1600;
 const unsigned int SCR_HEIGHT = 900;
 
-int main()
+int main(int argc, char** argv)
 {
+	// --terrain <file> swaps the terrain graph, for the game and benchmarks alike
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--terrain") == 0)
+			TerrainGraph::SetPath(argv[i + 1]);
+	}
+
+	// headless benchmarks, no window
+	if (argc > 2 && strcmp(argv[1], "--bench") == 0)
+		return Benchmark::Run(argv[2]);
+
 	glfwInit();
 	Window window(SCR_WIDTH, SCR_HEIGHT);
 	if (window.Init() < 0)